@@ -7,6 +7,7 @@
 
 #include "ssp_hal.h"
 #include "ssp_osal.h"
+#include "ssp_crc.h"
 #include "ssp_fault.h"
 #include <Arduino.h>
 
@@ -222,5 +223,29 @@ BOOL SSPHAL_IsPowerSave(void)
     return powerSave;
 }
 
+BOOL SSPHAL_CrcOffloadSupported(SspPortId portId, SspFrameCheck frameCheck)
+{
+    (void)portId;
+    (void)frameCheck;
+
+    /// @TODO: Return TRUE if the port CRC hardware computes the frame check
+    return FALSE;
+}
+
+UINT32 SSPHAL_CrcCompute(SspPortId portId, SspFrameCheck frameCheck, 
+    const UINT8* data, UINT16 dataSize, UINT32 crc)
+{
+    (void)portId;
+
+    /// @TODO: Compute the CRC using the port CRC hardware. Software CRC until then.
+#ifdef USE_SSP_CRC32C
+    if (frameCheck == SSP_FRAME_CHECK_CRC32C)
+        return Crc32cCalcBlock(data, dataSize, crc);
+#else
+    (void)frameCheck;
+#endif
+    return Crc16CalcBlock((unsigned char*)data, dataSize, (unsigned short)crc);
+}
+
 #endif
 
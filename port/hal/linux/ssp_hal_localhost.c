@@ -18,6 +18,7 @@
 #include "ssp_hal.h"
 #include "ssp_osal.h"
 #include "ssp_fault.h"
+#include "ssp_crc.h"
 
 #define SEND_RETRY_MAX      2
 #define SEND_RETRY_DELAY    5   // in mS
@@ -36,9 +37,13 @@ const char *ip = "10.15.154.18";       // Use localhost
 
 static INT g_sockfd[SSP_MAX_PORTS] = { -1 }; //If more Ports, more g_sockfd's needed
 
+// Last SO_RCVTIMEO set on each socket in mS. -1 if not set.
+static INT32 g_recvTimeout[SSP_MAX_PORTS];
+
 void SSPHAL_Init(SspPortId portId) {
    for (INT port = 0; port < SSP_MAX_PORTS; port++) {
       g_sockfd[port] = -1;
+      g_recvTimeout[port] = -1;
       g_port_lock[port] = SSPOSAL_LockCreate();
       ASSERT_TRUE(g_port_lock[port] != SSP_OSAL_INVALID_HANDLE_VALUE);
    }
@@ -108,6 +113,7 @@ void SSPHAL_PortClose(SspPortId portId) {
    {
       close(g_sockfd[portId]);
       g_sockfd[portId] = -1;
+      g_recvTimeout[portId] = -1;
    }
 
    SSPOSAL_LockPut(g_port_lock[portId]);
@@ -191,10 +197,14 @@ BOOL SSPHAL_PortRecv(SspPortId portId, char *buf, UINT16 *bytesRead,
 
    *bytesRead = 0;
 
-   if (setsockopt(g_sockfd[portId], SOL_SOCKET, SO_RCVTIMEO, &tv,
-         sizeof(tv)) < 0) {
-	  printf("setsockopt failed:%d,(%s)\n", errno, strerror(errno));
-      goto error;
+   // Only set the receive timeout when changed
+   if (g_recvTimeout[portId] != timeout) {
+      if (setsockopt(g_sockfd[portId], SOL_SOCKET, SO_RCVTIMEO, &tv,
+            sizeof(tv)) < 0) {
+         printf("setsockopt failed:%d,(%s)\n", errno, strerror(errno));
+         goto error;
+      }
+      g_recvTimeout[portId] = timeout;
    }
 
 
@@ -271,4 +281,23 @@ BOOL SSPHAL_IsPowerSave(void) {
    return powerSave;
 }
 
+// Software reference for the CRC offload. Replace with a call to a CRC 
+// peripheral or DMA driver that computes checksums.
+BOOL SSPHAL_CrcOffloadSupported(SspPortId portId, SspFrameCheck frameCheck) {
+#ifdef USE_SSP_CRC32C
+   return (frameCheck == SSP_FRAME_CHECK_CRC16 || frameCheck == SSP_FRAME_CHECK_CRC32C);
+#else
+   return (frameCheck == SSP_FRAME_CHECK_CRC16);
+#endif
+}
+
+UINT32 SSPHAL_CrcCompute(SspPortId portId, SspFrameCheck frameCheck, 
+   const UINT8* data, UINT16 dataSize, UINT32 crc) {
+#ifdef USE_SSP_CRC32C
+   if (frameCheck == SSP_FRAME_CHECK_CRC32C)
+      return Crc32cCalcBlock(data, dataSize, crc);
+#endif
+   return Crc16CalcBlock((unsigned char*)data, dataSize, (unsigned short)crc);
+}
+
 #endif
\ No newline at end of file
@@ -9,6 +9,24 @@ static SSP_OSAL_HANDLE _hLock;
 #define LK_LOCK(h)      SSPOSAL_LockGet(h, 5000)
 #define LK_UNLOCK(h)    SSPOSAL_LockPut(h)
 
+// Each allocator free-list is a lock-free stack if the CPU supports 8-byte 
+// compare-and-swap. Otherwise one lock guards each allocate and free, and the
+// atomic operations below are plain operations.
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ALLOC_LOCK_FREE
+#elif defined(__GNUC__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+#define ALLOC_LOCK_FREE
+#endif
+
+#ifdef ALLOC_LOCK_FREE
+#define ALLOC_LOCK()
+#define ALLOC_UNLOCK()
+#else
+#define ALLOC_LOCK()    LK_LOCK(_hLock)
+#define ALLOC_UNLOCK()  LK_UNLOCK(_hLock)
+#endif
+
 // Get a pointer to the client's area within a memory block
 #define GET_CLIENT_PTR(_block_ptr_) \
     (_block_ptr_ ? ((void*)((char*)_block_ptr_)) : NULL)
@@ -17,9 +35,177 @@ static SSP_OSAL_HANDLE _hLock;
 #define GET_BLOCK_PTR(_client_ptr_) \
     (_client_ptr_ ? ((void*)((char*)_client_ptr_)) : NULL)
 
+// Free-list head fields
+#define HEAD_INDEX(_head_)      ((UINT32)(_head_))
+#define HEAD_TAG(_head_)        ((UINT32)((_head_) >> 32))
+#define HEAD_MAKE(_tag_, _index_) (((UINT64)(_tag_) << 32) | (_index_))
+
+// Convert between a block pointer and the block index + 1 within the pool
+#define BLOCK_INDEX(_alloc_, _block_ptr_) \
+    ((UINT32)(((const char*)(_block_ptr_) - (_alloc_)->pPool) / (_alloc_)->blockSize) + 1)
+#define BLOCK_PTR(_alloc_, _index_) \
+    ((void*)((_alloc_)->pPool + (((_index_) - 1) * (_alloc_)->blockSize)))
+
+// Per-thread magazines cache free blocks using thread-local storage
+#if defined(USE_SSP_ALLOC_MAGAZINE) && defined(ALLOC_LOCK_FREE)
+#if defined(_MSC_VER)
+#define ALLOC_THREAD_LOCAL  __declspec(thread)
+#define ALLOC_MAGAZINE
+#elif defined(__GNUC__)
+#define ALLOC_THREAD_LOCAL  __thread
+#define ALLOC_MAGAZINE
+#endif
+#endif
+
+#ifdef ALLOC_MAGAZINE
+// Maximum number of allocators cached by each thread
+#define ALLOC_MAGAZINES         8
+
+// Number of blocks moved between a magazine and the free-list at once
+#define ALLOC_MAGAZINE_BATCH    ((SSP_ALLOC_MAGAZINE_SIZE + 1) / 2)
+
+// Maximum number of magazine allocations or deallocations counted before 
+// the counts are added to the allocator statistics
+#define ALLOC_MAGAZINE_FOLD     64
+
+// A thread's cache of free blocks for one allocator
+typedef struct
+{
+    ALLOC_Allocator* alloc;
+    UINT16 count;
+    void* pBlocks[SSP_ALLOC_MAGAZINE_SIZE];
+
+    // Allocations and deallocations not yet added to the allocator statistics
+    UINT32 allocations;
+    UINT32 deallocations;
+} ALLOC_Magazine;
+
+static ALLOC_THREAD_LOCAL ALLOC_Magazine _magazines[ALLOC_MAGAZINES];
+
+static ALLOC_Magazine* ALLOC_GetMagazine(ALLOC_Allocator* alloc);
+static void* ALLOC_MagazinePop(ALLOC_Allocator* alloc);
+static void ALLOC_MagazinePush(ALLOC_Allocator* alloc, void* pBlock);
+static void ALLOC_MagazineFold(ALLOC_Allocator* alloc, ALLOC_Magazine* mag, INT32 blocks);
+#endif
+
+static UINT64 ALLOC_AtomicLoad64(UINT64* p);
+static BOOL ALLOC_AtomicCas64(UINT64* p, UINT64* expected, UINT64 desired);
+static UINT32 ALLOC_AtomicAdd32(UINT32* p, INT32 value);
+static void ALLOC_AtomicAdd64(UINT64* p, UINT32 value);
+static void ALLOC_AtomicMax32(UINT32* p, UINT32 value);
+static void ALLOC_InUse(ALLOC_Allocator* alloc, INT32 blocks);
 static void* ALLOC_NewBlock(ALLOC_Allocator* alloc);
-static void ALLOC_Push(ALLOC_Allocator* alloc, void* pBlock);
-static void* ALLOC_Pop(ALLOC_Allocator* alloc);
+static void* ALLOC_Get(ALLOC_Allocator* alloc);
+static void ALLOC_Push(ALLOC_Allocator* alloc, void** pBlocks, UINT16 count);
+static UINT16 ALLOC_Pop(ALLOC_Allocator* alloc, void** pBlocks, UINT16 count);
+
+//----------------------------------------------------------------------------
+// ALLOC_AtomicLoad64
+//----------------------------------------------------------------------------
+static UINT64 ALLOC_AtomicLoad64(UINT64* p)
+{
+#if defined(_MSC_VER)
+    return (UINT64)_InterlockedCompareExchange64((volatile __int64*)p, 0, 0);
+#elif defined(ALLOC_LOCK_FREE)
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+    return *p;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// ALLOC_AtomicCas64
+// Store desired if *p equals expected. Otherwise, expected is set to *p.
+//----------------------------------------------------------------------------
+static BOOL ALLOC_AtomicCas64(UINT64* p, UINT64* expected, UINT64 desired)
+{
+#if defined(_MSC_VER)
+    UINT64 prev = (UINT64)_InterlockedCompareExchange64((volatile __int64*)p, 
+        (__int64)desired, (__int64)*expected);
+    if (prev == *expected)
+        return TRUE;
+    *expected = prev;
+    return FALSE;
+#elif defined(ALLOC_LOCK_FREE)
+    return __atomic_compare_exchange_n(p, expected, desired, 0, 
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ? TRUE : FALSE;
+#else
+    if (*p != *expected)
+    {
+        *expected = *p;
+        return FALSE;
+    }
+    *p = desired;
+    return TRUE;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// ALLOC_AtomicAdd32
+// Returns the new value.
+//----------------------------------------------------------------------------
+static UINT32 ALLOC_AtomicAdd32(UINT32* p, INT32 value)
+{
+#if defined(_MSC_VER)
+    return (UINT32)_InterlockedExchangeAdd((volatile long*)p, value) + value;
+#elif defined(ALLOC_LOCK_FREE)
+    return __atomic_add_fetch(p, value, __ATOMIC_RELAXED);
+#else
+    return (*p += value);
+#endif
+}
+
+//----------------------------------------------------------------------------
+// ALLOC_AtomicAdd64
+//----------------------------------------------------------------------------
+static void ALLOC_AtomicAdd64(UINT64* p, UINT32 value)
+{
+#if defined(_MSC_VER)
+    _InterlockedExchangeAdd64((volatile __int64*)p, (__int64)value);
+#elif defined(ALLOC_LOCK_FREE)
+    __atomic_add_fetch(p, value, __ATOMIC_RELAXED);
+#else
+    *p += value;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// ALLOC_AtomicMax32
+// Store value if greater than *p.
+//----------------------------------------------------------------------------
+static void ALLOC_AtomicMax32(UINT32* p, UINT32 value)
+{
+#if defined(_MSC_VER)
+    long prev = *(volatile long*)p;
+    long cur;
+    while ((UINT32)prev < value)
+    {
+        cur = _InterlockedCompareExchange((volatile long*)p, (long)value, prev);
+        if (cur == prev)
+            break;
+        prev = cur;
+    }
+#elif defined(ALLOC_LOCK_FREE)
+    UINT32 prev = __atomic_load_n(p, __ATOMIC_RELAXED);
+    while (prev < value && 
+        !__atomic_compare_exchange_n(p, &prev, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+#else
+    if (*p < value)
+        *p = value;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// ALLOC_InUse
+// Add to the blocks in use and update the high-water mark.
+//----------------------------------------------------------------------------
+static void ALLOC_InUse(ALLOC_Allocator* self, INT32 blocks)
+{
+    UINT32 inUse = ALLOC_AtomicAdd32(&self->blocksInUse, blocks);
+    if (blocks > 0)
+        ALLOC_AtomicMax32(&self->maxBlocksInUse, inUse);
+}
 
 //----------------------------------------------------------------------------
 // ALLOC_NewBlock
@@ -27,22 +213,19 @@ static void* ALLOC_Pop(ALLOC_Allocator* alloc);
 static void* ALLOC_NewBlock(ALLOC_Allocator* self)
 {
     ALLOC_Block* pBlock = NULL;
-
-    LK_LOCK(_hLock);
+    UINT32 index;
 
     // If we have not exceeded the pool maximum
-    if (self->poolIndex < self->maxBlocks)
+    index = ALLOC_AtomicAdd32(&self->poolIndex, 1) - 1;
+    if (index < self->maxBlocks)
     {
         // Get pointer to a new fixed memory block within the pool
-        pBlock = (void*)(self->pPool + (self->poolIndex++ * self->blockSize));
+        pBlock = (void*)(self->pPool + (index * self->blockSize));
     }
-
-    LK_UNLOCK(_hLock);
-
-    if (!pBlock)
+    else
     {
-        // Out of fixed block memory
-        ASSERT();
+        // Keep the pool index at the maximum
+        ALLOC_AtomicAdd32(&self->poolIndex, -1);
     }
 
     return pBlock;
@@ -50,48 +233,208 @@ static void* ALLOC_NewBlock(ALLOC_Allocator* self)
 
 //----------------------------------------------------------------------------
 // ALLOC_Push
+// Push count blocks onto the free-list using one compare-and-swap.
 //----------------------------------------------------------------------------
-static void ALLOC_Push(ALLOC_Allocator* self, void* pBlock)
+static void ALLOC_Push(ALLOC_Allocator* self, void** pBlocks, UINT16 count)
 {
-    if (!pBlock)
+    ALLOC_Block block;
+    UINT64 head;
+    UINT16 i;
+
+    if (!count)
         return;
 
-    // Get a pointer to the client's location within the block
-    ALLOC_Block* pClient = (ALLOC_Block*)GET_CLIENT_PTR(pBlock);
+    // Link the blocks in order
+    for (i = 0; i + 1 < count; i++)
+    {
+        block.next = BLOCK_INDEX(self, pBlocks[i + 1]);
+        memcpy(pBlocks[i], &block, sizeof(block));
+    }
+
+    head = ALLOC_AtomicLoad64(&self->head);
+    do
+    {
+        // Point the last block's next index to head
+        block.next = HEAD_INDEX(head);
+        memcpy(pBlocks[count - 1], &block, sizeof(block));
+
+        // The first block is now the new head
+    } while (!ALLOC_AtomicCas64(&self->head, &head, 
+        HEAD_MAKE(HEAD_TAG(head) + 1, BLOCK_INDEX(self, pBlocks[0]))));
+}
+
+//----------------------------------------------------------------------------
+// ALLOC_Pop
+// Pop up to count blocks from the free-list using one compare-and-swap. 
+// Returns the number of blocks popped. pBlocks is only written once the
+// blocks are owned, so a failed pop leaves it unchanged.
+//----------------------------------------------------------------------------
+static UINT16 ALLOC_Pop(ALLOC_Allocator* self, void** pBlocks, UINT16 count)
+{
+    ALLOC_Block block;
+    UINT64 head;
+    UINT32 first;
+    UINT32 index;
+    UINT16 n;
+
+    head = ALLOC_AtomicLoad64(&self->head);
+    do
+    {
+        // Walk the blocks from the head. Another thread may pop a block and 
+        // write over the next index first, but then the tag differs and the 
+        // compare-and-swap fails. 
+        n = 0;
+        first = HEAD_INDEX(head);
+        index = first;
+        while (index != 0 && index <= self->maxBlocks && n < count)
+        {
+            memcpy(&block, BLOCK_PTR(self, index), sizeof(block));
+            index = block.next;
+            n++;
+        }
+
+        // Is the free-list empty?
+        if (n == 0)
+            return 0;
+
+        // Set the head to the next block
+    } while (!ALLOC_AtomicCas64(&self->head, &head, HEAD_MAKE(HEAD_TAG(head) + 1, index)));
+
+    // The popped blocks are owned by this thread. Follow the links again.
+    index = first;
+    for (count = 0; count < n; count++)
+    {
+        pBlocks[count] = BLOCK_PTR(self, index);
+        memcpy(&block, pBlocks[count], sizeof(block));
+        index = block.next;
+    }
 
-    LK_LOCK(_hLock);
+    return n;
+} 
 
-    // Point client block's next pointer to head
-    pClient->pNext = self->pHead;
+#ifdef ALLOC_MAGAZINE
+//----------------------------------------------------------------------------
+// ALLOC_GetMagazine
+// Get this thread's magazine for an allocator. Returns NULL if all in use.
+//----------------------------------------------------------------------------
+static ALLOC_Magazine* ALLOC_GetMagazine(ALLOC_Allocator* self)
+{
+    UINT16 i;
 
-    // The client block is now the new head
-    self->pHead = pClient;
+    for (i = 0; i < ALLOC_MAGAZINES; i++)
+    {
+        if (_magazines[i].alloc == self)
+            return &_magazines[i];
 
-    LK_UNLOCK(_hLock); 
+        if (_magazines[i].alloc == NULL)
+        {
+            _magazines[i].alloc = self;
+            return &_magazines[i];
+        }
+    }
+    return NULL;
 }
 
 //----------------------------------------------------------------------------
-// ALLOC_Pop
+// ALLOC_MagazineFold
+// Add this thread's magazine counts to the allocator statistics. Blocks 
+// cached within magazines are counted as in use, so blocks in use only 
+// changes when blocks move to or from the free-list.
 //----------------------------------------------------------------------------
-static void* ALLOC_Pop(ALLOC_Allocator* self)
+static void ALLOC_MagazineFold(ALLOC_Allocator* self, ALLOC_Magazine* mag, INT32 blocks)
 {
-    ALLOC_Block* pBlock = NULL;
+    if (mag->allocations)
+    {
+        ALLOC_AtomicAdd64(&self->allocations, mag->allocations);
+        mag->allocations = 0;
+    }
+    if (mag->deallocations)
+    {
+        ALLOC_AtomicAdd64(&self->deallocations, mag->deallocations);
+        mag->deallocations = 0;
+    }
+    if (blocks)
+        ALLOC_InUse(self, blocks);
+}
 
-    LK_LOCK(_hLock);
+//----------------------------------------------------------------------------
+// ALLOC_MagazinePop
+// Get a block from this thread's magazine. An empty magazine is refilled 
+// from the free-list or the pool. Statistics are only updated on refill.
+//----------------------------------------------------------------------------
+static void* ALLOC_MagazinePop(ALLOC_Allocator* self)
+{
+    ALLOC_Magazine* mag = ALLOC_GetMagazine(self);
+    void* pBlock = NULL;
+    UINT16 count;
 
-    // Is the free-list empty?
-    if (self->pHead)
+    if (!mag)
     {
-        // Remove the head block
-        pBlock = self->pHead;
+        if (!ALLOC_Pop(self, &pBlock, 1))
+            pBlock = ALLOC_NewBlock(self);
+        if (pBlock)
+        {
+            ALLOC_AtomicAdd64(&self->allocations, 1);
+            ALLOC_InUse(self, 1);
+        }
+        return pBlock;
+    }
 
-        // Set the head to the next block
-        self->pHead = self->pHead->pNext;
+    if (mag->count == 0)
+    {
+        count = ALLOC_Pop(self, mag->pBlocks, ALLOC_MAGAZINE_BATCH);
+        if (!count)
+        {
+            // Free-list empty. Get a new block from the pool.
+            mag->pBlocks[0] = ALLOC_NewBlock(self);
+            if (mag->pBlocks[0])
+                count = 1;
+        }
+        mag->count = count;
+        ALLOC_MagazineFold(self, mag, count);
     }
 
-    LK_UNLOCK(_hLock); 
-    return GET_BLOCK_PTR(pBlock);
-} 
+    if (mag->count)
+    {
+        pBlock = mag->pBlocks[--mag->count];
+        if (++mag->allocations >= ALLOC_MAGAZINE_FOLD)
+            ALLOC_MagazineFold(self, mag, 0);
+    }
+
+    return pBlock;
+}
+
+//----------------------------------------------------------------------------
+// ALLOC_MagazinePush
+// Put a block into this thread's magazine. The oldest blocks of a full 
+// magazine are returned to the free-list. Statistics are only updated when
+// blocks are returned.
+//----------------------------------------------------------------------------
+static void ALLOC_MagazinePush(ALLOC_Allocator* self, void* pBlock)
+{
+    ALLOC_Magazine* mag = ALLOC_GetMagazine(self);
+
+    if (!mag)
+    {
+        ALLOC_Push(self, &pBlock, 1);
+        ALLOC_AtomicAdd64(&self->deallocations, 1);
+        ALLOC_InUse(self, -1);
+        return;
+    }
+
+    if (mag->count == SSP_ALLOC_MAGAZINE_SIZE)
+    {
+        ALLOC_Push(self, mag->pBlocks, ALLOC_MAGAZINE_BATCH);
+        mag->count -= ALLOC_MAGAZINE_BATCH;
+        memmove(mag->pBlocks, &mag->pBlocks[ALLOC_MAGAZINE_BATCH], mag->count * sizeof(void*));
+        ALLOC_MagazineFold(self, mag, -ALLOC_MAGAZINE_BATCH);
+    }
+
+    mag->pBlocks[mag->count++] = pBlock;
+    if (++mag->deallocations >= ALLOC_MAGAZINE_FOLD)
+        ALLOC_MagazineFold(self, mag, 0);
+}
+#endif
 
 //----------------------------------------------------------------------------
 // ALLOC_Init
@@ -109,6 +452,43 @@ void ALLOC_Term()
     LK_DESTROY(_hLock);
 }
 
+//----------------------------------------------------------------------------
+// ALLOC_Get
+// Get a free block. Returns NULL if the pool is exhausted.
+//----------------------------------------------------------------------------
+static void* ALLOC_Get(ALLOC_Allocator* self)
+{
+    void* pBlock = NULL;
+
+    ALLOC_LOCK();
+
+    // Get a block from this thread's magazine
+#ifdef ALLOC_MAGAZINE
+    pBlock = ALLOC_MagazinePop(self);
+#else
+    // Get a block from the free-list
+    if (!ALLOC_Pop(self, &pBlock, 1))
+    {
+        // Free-list empty. Get a new block from the pool.
+        pBlock = ALLOC_NewBlock(self);
+    }
+
+    // Keep track of usage statistics
+    if (pBlock)
+    {
+        ALLOC_AtomicAdd64(&self->allocations, 1);
+        ALLOC_InUse(self, 1);
+    }
+#endif
+
+    if (!pBlock)
+        ALLOC_AtomicAdd64(&self->failedAllocations, 1);
+
+    ALLOC_UNLOCK();
+
+    return pBlock;
+}
+
 //----------------------------------------------------------------------------
 // ALLOC_Alloc
 //----------------------------------------------------------------------------
@@ -125,25 +505,11 @@ void* ALLOC_Alloc(ALLOC_HANDLE hAlloc, size_t size)
     // Ensure requested size fits within memory block 
     ASSERT_TRUE(size <= self->blockSize);
 
-    // Get a block from the free-list
-    pBlock = ALLOC_Pop(self);
-
-    // If the free-list empty?
+    pBlock = ALLOC_Get(self);
     if (!pBlock)
     {
-        // Get a new block from the pool
-        pBlock = ALLOC_NewBlock(self);
-    }
-
-    if (pBlock)
-    {
-        // Keep track of usage statistics
-        self->allocations++;
-        self->blocksInUse++;
-        if (self->blocksInUse > self->maxBlocksInUse)
-        {
-            self->maxBlocksInUse = self->blocksInUse;
-        }
+        // Out of fixed block memory
+        ASSERT();
     }
 
     return GET_CLIENT_PTR(pBlock);
@@ -174,6 +540,57 @@ void* ALLOC_Calloc(ALLOC_HANDLE hAlloc, size_t num, size_t size)
     return pMem;
 }
 
+//----------------------------------------------------------------------------
+// ALLOC_TryCalloc
+// Same as ALLOC_Calloc() except returns NULL if the pool is exhausted.
+//----------------------------------------------------------------------------
+void* ALLOC_TryCalloc(ALLOC_HANDLE hAlloc, size_t num, size_t size)
+{
+    ALLOC_Allocator* self = NULL;
+    void* pMem = NULL;
+    size_t n = 0;
+
+    ASSERT_TRUE(hAlloc);
+
+    // Convert handle to an ALLOC_Allocator instance
+    self = (ALLOC_Allocator*)hAlloc;
+
+    // Compute the total size of the block
+    n = num * size;
+
+    // Ensure requested size fits within memory block 
+    ASSERT_TRUE(n <= self->blockSize);
+
+    // Allocate the memory
+    pMem = ALLOC_Get(self);
+    pMem = GET_CLIENT_PTR(pMem);
+
+    if (pMem != NULL)
+    {
+        // Initialize memory to 0 per calloc behavior 
+        memset(pMem, 0, n);
+    }
+
+    return pMem;
+}
+
+//----------------------------------------------------------------------------
+// ALLOC_Contains
+// Returns TRUE if the block is within the allocator pool.
+//----------------------------------------------------------------------------
+BOOL ALLOC_Contains(ALLOC_HANDLE hAlloc, const void* pBlock)
+{
+    const ALLOC_Allocator* self = NULL;
+
+    ASSERT_TRUE(hAlloc);
+
+    // Cast handle to an allocator instance
+    self = (const ALLOC_Allocator*)hAlloc;
+
+    return ((const char*)pBlock >= self->pPool && 
+        (const char*)pBlock < self->pPool + (self->maxBlocks * self->blockSize)) ? TRUE : FALSE;
+}
+
 //----------------------------------------------------------------------------
 // ALLOC_Free
 //----------------------------------------------------------------------------
@@ -192,13 +609,72 @@ void ALLOC_Free(ALLOC_HANDLE hAlloc, void* pBlock)
     // Get a pointer to the block
     pBlock = GET_BLOCK_PTR(pBlock);
 
+    ALLOC_LOCK();
+
     // Push the block onto a stack (i.e. the free-list)
-    ALLOC_Push(self, pBlock);
+#ifdef ALLOC_MAGAZINE
+    ALLOC_MagazinePush(self, pBlock);
+#else
+    ALLOC_Push(self, &pBlock, 1);
 
     // Keep track of usage statistics
-    self->deallocations++;
-    self->blocksInUse--;
+    ALLOC_AtomicAdd64(&self->deallocations, 1);
+    ALLOC_InUse(self, -1);
+#endif
+
+    ALLOC_UNLOCK();
 } 
 
+//----------------------------------------------------------------------------
+// ALLOC_ThreadFlush
+// Return the blocks cached by the calling thread to the free-lists. Call 
+// before a thread using the allocators exits.
+//----------------------------------------------------------------------------
+void ALLOC_ThreadFlush(void)
+{
+#ifdef ALLOC_MAGAZINE
+    UINT16 i;
 
+    for (i = 0; i < ALLOC_MAGAZINES; i++)
+    {
+        if (_magazines[i].alloc)
+        {
+            ALLOC_Push(_magazines[i].alloc, _magazines[i].pBlocks, _magazines[i].count);
+            ALLOC_MagazineFold(_magazines[i].alloc, &_magazines[i], -(INT32)_magazines[i].count);
+        }
+        _magazines[i].alloc = NULL;
+        _magazines[i].count = 0;
+    }
+#endif
+}
 
+//----------------------------------------------------------------------------
+// ALLOC_GetStats
+// Get the allocator usage statistics. Counters are updated concurrently, so
+// each value is read individually. With per-thread magazines, each thread's 
+// counts are added when its magazine moves blocks to or from the free-list 
+// or every ALLOC_MAGAZINE_FOLD operations, and cached blocks count as in use.
+//----------------------------------------------------------------------------
+void ALLOC_GetStats(ALLOC_HANDLE hAlloc, ALLOC_Stats* stats)
+{
+    ALLOC_Allocator* self = NULL;
+
+    ASSERT_TRUE(hAlloc);
+    ASSERT_TRUE(stats);
+
+    // Cast handle to an allocator instance
+    self = (ALLOC_Allocator*)hAlloc;
+
+    ALLOC_LOCK();
+
+    stats->name = self->name;
+    stats->blockSize = (UINT32)self->blockSize;
+    stats->maxBlocks = self->maxBlocks;
+    stats->blocksInUse = ALLOC_AtomicAdd32(&self->blocksInUse, 0);
+    stats->maxBlocksInUse = ALLOC_AtomicAdd32(&self->maxBlocksInUse, 0);
+    stats->allocations = ALLOC_AtomicLoad64(&self->allocations);
+    stats->deallocations = ALLOC_AtomicLoad64(&self->deallocations);
+    stats->failedAllocations = ALLOC_AtomicLoad64(&self->failedAllocations);
+
+    ALLOC_UNLOCK();
+}
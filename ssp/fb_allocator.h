@@ -5,7 +5,10 @@
 //
 // Create an allocator instance using the ALLOC_DEFINE macro. Call 
 // ALLOC_Init() one time at startup. ALLOC_Alloc() allocates a fixed 
-// memory block. ALLOC_Free() frees the block. 
+// memory block. ALLOC_Free() frees the block. Each allocator free-list is a 
+// lock-free stack on CPUs supporting an 8-byte compare-and-swap. Otherwise, 
+// a single lock guards all allocators. Define USE_SSP_ALLOC_MAGAZINE to also 
+// cache free blocks per thread. 
 //
 // #include "fb_allocator.h"
 // ALLOC_DEFINE(myAllocator, 32, 5)
@@ -23,6 +26,7 @@
 
 #include <stdlib.h>
 #include "ssp_types.h"
+#include "ssp_opt.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,11 +34,19 @@ extern "C" {
 
 typedef void* ALLOC_HANDLE;
 
+// A free block holds the index of the next free block within the pool
 typedef struct 
 {
-    void* pNext;
+    UINT32 next;
 } ALLOC_Block;
 
+// Align the free-list head for 8-byte atomic operations and the block pools
+#if defined(__GNUC__)
+#define ALLOC_ALIGN8 __attribute__((aligned(8)))
+#else
+#define ALLOC_ALIGN8
+#endif
+
 // Use ALLOC_DEFINE to declare an ALLOC_Allocator object
 typedef struct
 {
@@ -43,14 +55,32 @@ typedef struct
     const size_t objectSize;
     const size_t blockSize;
     const UINT32 maxBlocks;
-    ALLOC_Block* pHead;
-    UINT16 poolIndex;
-    UINT16 blocksInUse;
-    UINT16 maxBlocksInUse;
-    UINT16 allocations;
-    UINT16 deallocations;
+
+    // Free-list head. Low 32 bits are the head block index + 1 (0 if empty) and
+    // high 32 bits are a tag changed on every update to prevent ABA races.
+    UINT64 head ALLOC_ALIGN8;
+
+    UINT32 poolIndex;
+    UINT32 blocksInUse;
+    UINT32 maxBlocksInUse;
+    UINT64 allocations ALLOC_ALIGN8;
+    UINT64 deallocations ALLOC_ALIGN8;
+    UINT64 failedAllocations ALLOC_ALIGN8;
 } ALLOC_Allocator;
 
+// Allocator usage statistics returned by ALLOC_GetStats()
+typedef struct
+{
+    const char* name;
+    UINT32 blockSize;
+    UINT32 maxBlocks;
+    UINT32 blocksInUse;
+    UINT32 maxBlocksInUse;
+    UINT64 allocations;
+    UINT64 deallocations;
+    UINT64 failedAllocations;
+} ALLOC_Stats;
+
 // Align fixed blocks on X-byte boundary based on CPU architecture.
 // Set value to 1, 2, 4 or 8.
 #define ALLOC_MEM_ALIGN   (1)
@@ -63,9 +93,22 @@ typedef struct
     (((_numToRound_ + _multiple_ - 1) / _multiple_) * _multiple_)
 
 // Ensure the memory block size is: (a) is aligned on desired boundary and (b) at
-// least the size of a ALLOC_Allocator*. 
+// least the size of a ALLOC_Block. 
 #define ALLOC_BLOCK_SIZE(_size_) \
-    (ALLOC_MAX((ALLOC_ROUND_UP(_size_, ALLOC_MEM_ALIGN)), sizeof(ALLOC_Allocator*)))
+    (ALLOC_MAX((ALLOC_ROUND_UP(_size_, ALLOC_MEM_ALIGN)), sizeof(ALLOC_Block)))
+
+// Number of extra blocks in each pool for per-thread magazine caches
+#ifdef USE_SSP_ALLOC_MAGAZINE
+#ifndef SSP_ALLOC_MAGAZINE_SIZE
+#define SSP_ALLOC_MAGAZINE_SIZE     4
+#endif
+#ifndef SSP_ALLOC_MAGAZINE_THREADS
+#define SSP_ALLOC_MAGAZINE_THREADS  4
+#endif
+#define ALLOC_MAGAZINE_RESERVE  (SSP_ALLOC_MAGAZINE_SIZE * SSP_ALLOC_MAGAZINE_THREADS)
+#else
+#define ALLOC_MAGAZINE_RESERVE  0
+#endif
 
 // Defines block memory, allocator instance and a handle. On the example below, 
 // the ALLOC_Allocator instance is myAllocatorObj and the handle is myAllocator.
@@ -74,16 +117,20 @@ typedef struct
 // _objects_ - number of fixed memory blocks 
 // e.g. ALLOC_DEFINE(myAllocator, 32, 10)
 #define ALLOC_DEFINE(_name_, _size_, _objects_) \
-    static char _name_##Memory[ALLOC_BLOCK_SIZE(_size_) * (_objects_)] = { 0 }; \
+    static char _name_##Memory[ALLOC_BLOCK_SIZE(_size_) * ((_objects_) + ALLOC_MAGAZINE_RESERVE)] ALLOC_ALIGN8 = { 0 }; \
     static ALLOC_Allocator _name_##Obj = { #_name_, _name_##Memory, _size_, \
-        ALLOC_BLOCK_SIZE(_size_), _objects_, NULL, 0, 0, 0, 0, 0 }; \
+        ALLOC_BLOCK_SIZE(_size_), (_objects_) + ALLOC_MAGAZINE_RESERVE, 0, 0, 0, 0, 0, 0, 0 }; \
     static ALLOC_HANDLE _name_ = &_name_##Obj;
 
 void ALLOC_Init(void);
 void ALLOC_Term(void);
 void* ALLOC_Alloc(ALLOC_HANDLE hAlloc, size_t size);
 void* ALLOC_Calloc(ALLOC_HANDLE hAlloc, size_t num, size_t size);
+void* ALLOC_TryCalloc(ALLOC_HANDLE hAlloc, size_t num, size_t size);
+BOOL ALLOC_Contains(ALLOC_HANDLE hAlloc, const void* pBlock);
 void ALLOC_Free(ALLOC_HANDLE hAlloc, void* pBlock);
+void ALLOC_ThreadFlush(void);
+void ALLOC_GetStats(ALLOC_HANDLE hAlloc, ALLOC_Stats* stats);
 
 #ifdef __cplusplus
 }
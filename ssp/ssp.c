@@ -17,7 +17,8 @@ typedef enum
 {
     MSG_TYPE_DATA,
     MSG_TYPE_ACK,
-    MSG_TYPE_NAK
+    MSG_TYPE_NAK,
+    MSG_TYPE_SACK
 } SspMsgType;
 
 typedef enum
@@ -38,34 +39,412 @@ typedef struct SendData
     // The current state of this packet transmission
     SendDataState state;
 
-    // SSP data to be transmitted
+    // SSP data to be transmitted. Stored within the same block following 
+    // the SendData structure.
     SspData* sspData;
 
     // Pointer to the next structure or NULL if list end
     struct SendData* next;
+
+    // Pointer to the previous structure or NULL if list head
+    struct SendData* prev;
+
+    // Pointer to the next structure within the same transaction ID index bucket
+    struct SendData* indexNext;
+
+    // Pointers to the next and previous structures sent to the same socket pair
+    struct SendData* pairNext;
+    struct SendData* pairPrev;
+
+#ifdef USE_SSP_FRAGMENTATION
+    // Fragmented message send state or NULL if the message is one packet
+    struct FragSend* frag;
+#endif
+
+    // Transaction ID of the message. A fragmented message uses one consecutive 
+    // transaction ID per fragment starting at this ID.
+    UINT16 msgTransId;
 } SendData;
 
+#ifdef USE_SSP_EXT_SEQ
+// Outgoing data messages use 16-bit transaction IDs
+#define DATA_EXT_FLAGS              SSP_FLAG_EXT_SEQ
+#else
+#define DATA_EXT_FLAGS              0
+#endif
+
+// Maximum size of ACK/NAK/SACK packet body extension fields
+#define MAX_EXT_SIZE                1
+
+// Size of the fragment extension fields
+#define FRAG_EXT_SIZE               4
+
+// Maximum number of fragments within a message
+#define MAX_FRAGMENTS               255
+
+// Number of 32-bit words within a bitmap holding one bit per fragment
+#define FRAG_BITMAP_WORDS           ((MAX_FRAGMENTS + 31) / 32)
+
+// Get or set the fragment index bit within a fragment bitmap
+#define FRAG_BIT_GET(_bitmap_, _index_) \
+    (((_bitmap_)[(_index_) / 32] >> ((_index_) % 32)) & 1)
+#define FRAG_BIT_SET(_bitmap_, _index_) \
+    ((_bitmap_)[(_index_) / 32] |= (UINT32)1 << ((_index_) % 32))
+
+// Fragment extension fields. A message is split into count fragments of equal 
+// size except the last fragment, which holds the remainder.
+typedef struct
+{
+    // Total message size
+    UINT16 size;
+
+    // Fragment index within the message
+    UINT8 index;
+
+    // Number of fragments within the message
+    UINT8 count;
+} Fragment;
+
+#ifdef USE_SSP_FRAGMENTATION
+// Outgoing fragmented message state. One SendData holds the whole message and
+// each fragment packet is built within its SspData when the fragment is sent.
+typedef struct FragSend
+{
+    // Message data. Stored within the same block following the FragSend structure.
+    UINT8* data;
+
+    // Total message size
+    UINT16 size;
+
+    // Number of fragments within the message
+    UINT8 count;
+
+    // Oldest fragment index not yet acknowledged
+    UINT8 base;
+
+    // Next fragment index not yet sent
+    UINT8 next;
+
+    // TRUE if the newest fragment sent is not a retransmission, so its ACK 
+    // measures the round trip time
+    BOOL rttSample;
+
+    // Acknowledged fragments. Bit n is fragment index n.
+    UINT32 acked[FRAG_BITMAP_WORDS];
+} FragSend;
+#endif
+
+// Number of transaction ID index buckets per port. Must be a power of 2.
+#define TRANS_ID_INDEX_SIZE         16
+#define TRANS_ID_INDEX(_transId_)   ((_transId_) & (TRANS_ID_INDEX_SIZE - 1))
+
+// Doubly linked list of outgoing SendData instances
+typedef struct
+{
+    // The first and last list elements or NULL if list empty
+    SendData* head;
+    SendData* tail;
+
+    // The number of elements within the list
+    UINT16 size;
+
+    // List elements indexed by transaction ID for fast ACK/NAK lookup
+    SendData* index[TRANS_ID_INDEX_SIZE];
+
+    // Fragmented list elements linked by indexNext. A fragmented message 
+    // matches the transaction ID of each fragment.
+    SendData* fragList;
+} SendDataList;
+
+// Outgoing SendData instances sent to one socket pair in transaction ID order
+typedef struct
+{
+    // The oldest and newest messages or NULL if none queued
+    SendData* head;
+    SendData* tail;
+
+    // The oldest fragmented message or NULL if none queued. The receiver 
+    // reassembles one message at a time so only this fragmented message is sent.
+    SendData* frag;
+} SendDataPair;
+
+// Number of transaction IDs older than the newest tracked by the replay window
+#define REPLAY_WINDOW_BITS  64
+
+// Received data message history used to reject duplicate messages
+typedef struct
+{
+    // TRUE after the first message is received
+    BOOL valid;
+
+    // Transaction ID mask of the received messages
+    UINT16 mask;
+
+    // Newest received transaction ID
+    UINT16 transId;
+
+    // Older received messages. Bit n is transaction ID (transId - 1 - n).
+    UINT64 bitmap;
+
+    // Received message CRC (low 16 bits) indexed by transaction ID modulo 
+    // REPLAY_WINDOW_BITS
+    UINT16 crc[REPLAY_WINDOW_BITS];
+
+    // Oldest transaction ID not yet received. Messages are accepted in 
+    // transaction ID order starting at this ID.
+    UINT16 nextTransId;
+
+    // TRUE if a message newer than nextTransId was received
+    BOOL gap;
+
+    // Time stamp when the first message newer than nextTransId was received
+    UINT32 gapTickStamp;
+} ReplayWindow;
+
+// Received message acknowledged and held until older messages arrive
+typedef struct
+{
+    // Retained receive buffer
+    SspData* sspData;
+
+    // The port the message was received on
+    SspPortId portId;
+} RecvHold;
+
+#ifdef USE_SSP_FRAGMENTATION
+#ifndef SSP_MAX_MESSAGE_SIZE
+// Maximum size of a fragmented message
+#define SSP_MAX_MESSAGE_SIZE        1024
+#endif
+
+// How long an incomplete message blocks a message from another source socket
+#define REASSEMBLY_TIMEOUT          (SSP_ACK_TIMEOUT_MAX * (SSP_MAX_RETRIES + 1))
+
+// Incoming fragmented message being reassembled
+typedef struct
+{
+    // TRUE while a message is incomplete
+    BOOL active;
+
+    // Source socket of the message
+    UINT8 srcId;
+
+    // Total message size
+    UINT16 size;
+
+    // Number of fragments within the message
+    UINT8 count;
+
+    // Number of fragments not yet received
+    UINT8 remaining;
+
+    // Received fragments. Bit n is fragment index n.
+    UINT32 fragments[FRAG_BITMAP_WORDS];
+
+    // Transaction ID of the first fragment
+    UINT16 transId;
+
+    // Time stamp when the last fragment was received
+    UINT32 tickStamp;
+
+    // Message data
+    UINT8 data[SSP_MAX_MESSAGE_SIZE];
+} Reassembly;
+#endif
+
+// Number of selective ACK bitmap bytes. Each bit acknowledges one message 
+// older than the SACK packet header transaction ID.
+#define SACK_BITMAP_SIZE    sizeof(UINT32)
+#define SACK_BITMAP_BITS    (SACK_BITMAP_SIZE * 8)
+
+// Received data messages waiting to be acknowledged
+typedef struct
+{
+    // TRUE if at least one message is waiting for an ACK
+    BOOL pending;
+
+    // Header of the newest message to acknowledge
+    SspPacketHeader header;
+
+    // Transaction ID of the newest message to acknowledge
+    UINT16 transId;
+
+    // Older messages to acknowledge. Bit n is transaction ID (transId - 1 - n).
+    UINT32 bitmap;
+
+    // Distance between the newest and oldest transaction IDs to acknowledge
+    UINT8 span;
+
+    // Time stamp when the first message was added
+    UINT32 tickStamp;
+} PendingAck;
+
+// Round trip time estimate used to compute the ACK timeout
 typedef struct
 {
-    // Transaction ID
-    UINT8 transId;
+    // TRUE after the first round trip time measurement
+    BOOL valid;
 
-    // Error check
-    UINT16 crc;
-} ReceivedTransId;
+    // Smoothed round trip time scaled by 8
+    INT32 srtt;
+
+    // Round trip time variance scaled by 4
+    INT32 rttvar;
+
+    // The current ACK timeout in mS
+    UINT32 ackTimeout;
+} RttEstimate;
 
 // Maximum number of SendData memory blocks
 #define MAX_SEND_DATA_BLOCKS        SSP_MAX_MESSAGES
 
+#ifndef SSP_DATA_BLOCKS_16
+#define SSP_DATA_BLOCKS_16          0
+#endif
+#ifndef SSP_DATA_BLOCKS_64
+#define SSP_DATA_BLOCKS_64          0
+#endif
+#ifndef SSP_DATA_BLOCKS_128
+#define SSP_DATA_BLOCKS_128         0
+#endif
+
+#if (SSP_DATA_BLOCKS_16 + SSP_DATA_BLOCKS_64 + SSP_DATA_BLOCKS_128) >= SSP_MAX_MESSAGES
+#error "SspData size class blocks must be less than SSP_MAX_MESSAGES"
+#endif
+
+// Maximum number of maximum body size SendData memory blocks
+#define MAX_SEND_DATA_MAX_BLOCKS    (MAX_SEND_DATA_BLOCKS - SSP_DATA_BLOCKS_16 - \
+    SSP_DATA_BLOCKS_64 - SSP_DATA_BLOCKS_128)
+
+// Size class body size, limited to the maximum body size
+#define SSP_DATA_CLASS_SIZE(_size_) \
+    ((_size_) < SSP_MAX_BODY_SIZE ? (_size_) : SSP_MAX_BODY_SIZE)
+
+// Offset of the SspData stored inline after the SendData structure
+#define SEND_DATA_OFFSET \
+    (((sizeof(SendData) + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*))
+
+// Size of a SendData block holding a body of _size_ bytes
+#define SEND_DATA_SIZE(_size_)      (SEND_DATA_OFFSET + SSP_DATA_SIZE(_size_))
+
+// Size of a SendData fixed block. Rounded up so each block within a pool 
+// starts on an 8-byte boundary.
+#define SEND_DATA_BLOCK_SIZE(_size_)    ALLOC_ROUND_UP(SEND_DATA_SIZE(_size_), 8)
+
+#ifdef USE_SSP_FRAGMENTATION
+#ifndef SSP_FRAG_MESSAGES
+// Maximum number of fragmented messages queued at once on all ports
+#define SSP_FRAG_MESSAGES           1
+#endif
+
+// Offset of the FragSend stored after a SendData holding a maximum size body
+#define FRAG_SEND_OFFSET \
+    (((SEND_DATA_SIZE(SSP_MAX_BODY_SIZE) + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*))
+
+// Size of a fragmented message SendData block holding _size_ bytes of message data
+#define SEND_FRAG_SIZE(_size_)      (FRAG_SEND_OFFSET + sizeof(FragSend) + (_size_))
+#endif
+
+#ifndef SSP_SEND_WINDOW
+// Maximum number of unacknowledged outgoing messages in flight per port
+#define SSP_SEND_WINDOW             1
+#endif
+
+#ifndef SSP_ACK_TIMEOUT_MIN
+// Minimum adaptive ACK timeout computed from measured round trip time
+#define SSP_ACK_TIMEOUT_MIN         20      // in mS
+#endif
+
+#ifndef SSP_ACK_TIMEOUT_MAX
+// Maximum adaptive ACK timeout computed from measured round trip time
+#define SSP_ACK_TIMEOUT_MAX         2000    // in mS
+#endif
+
+// Retransmitted messages must remain within the replay window
+#if SSP_SEND_WINDOW > REPLAY_WINDOW_BITS
+#error SSP_SEND_WINDOW must be less than or equal to REPLAY_WINDOW_BITS
+#endif
+
+// Maximum send window size
+#if SSP_MAX_MESSAGES < REPLAY_WINDOW_BITS
+#define MAX_SEND_WINDOW             SSP_MAX_MESSAGES
+#else
+#define MAX_SEND_WINDOW             REPLAY_WINDOW_BITS
+#endif
+
+#ifndef SSP_RECV_PACKET_BUDGET
+// Maximum number of packets received per port each SSP_Process() call
+#define SSP_RECV_PACKET_BUDGET      1
+#endif
+
+#ifndef SSP_RECV_TIME_BUDGET
+// Maximum time spent receiving per port each SSP_Process() call
+#define SSP_RECV_TIME_BUDGET        0   // in mS
+#endif
+
+#ifndef SSP_ACK_DELAY
+// How long to hold received message ACKs to combine them into one packet
+#define SSP_ACK_DELAY               0   // in mS
+#endif
+
 #ifdef USE_FB_ALLOCATOR
 // Define fixed block allocator and memory for SendData
-ALLOC_DEFINE(sendDataAllocator, sizeof(SendData), MAX_SEND_DATA_BLOCKS)
+ALLOC_DEFINE(sendDataAllocator, SEND_DATA_BLOCK_SIZE(SSP_MAX_BODY_SIZE), MAX_SEND_DATA_MAX_BLOCKS)
+
+// Define the smaller size class allocators. Small messages are allocated from 
+// the smallest class that fits, so queued messages don't each use a maximum 
+// body size block.
+#if (SSP_DATA_BLOCKS_16 > 0)
+ALLOC_DEFINE(sendData16Allocator, SEND_DATA_BLOCK_SIZE(SSP_DATA_CLASS_SIZE(16)), SSP_DATA_BLOCKS_16)
+#endif
+#if (SSP_DATA_BLOCKS_64 > 0)
+ALLOC_DEFINE(sendData64Allocator, SEND_DATA_BLOCK_SIZE(SSP_DATA_CLASS_SIZE(64)), SSP_DATA_BLOCKS_64)
+#endif
+#if (SSP_DATA_BLOCKS_128 > 0)
+ALLOC_DEFINE(sendData128Allocator, SEND_DATA_BLOCK_SIZE(SSP_DATA_CLASS_SIZE(128)), SSP_DATA_BLOCKS_128)
+#endif
+
+typedef struct
+{
+    ALLOC_HANDLE* hAlloc;
+    UINT16 bodySize;
+} SendDataClass;
+
+// SendData size classes, smallest first
+static const SendDataClass sendDataClasses[] =
+{
+#if (SSP_DATA_BLOCKS_16 > 0)
+    { &sendData16Allocator, SSP_DATA_CLASS_SIZE(16) },
+#endif
+#if (SSP_DATA_BLOCKS_64 > 0)
+    { &sendData64Allocator, SSP_DATA_CLASS_SIZE(64) },
+#endif
+#if (SSP_DATA_BLOCKS_128 > 0)
+    { &sendData128Allocator, SSP_DATA_CLASS_SIZE(128) },
+#endif
+    { &sendDataAllocator, SSP_MAX_BODY_SIZE }
+};
+
+#define SEND_DATA_CLASSES   (sizeof(sendDataClasses) / sizeof(sendDataClasses[0]))
+
+#ifdef USE_SSP_FRAGMENTATION
+// Define fixed block allocator and memory for fragmented message SendData
+ALLOC_DEFINE(sendFragAllocator, ALLOC_ROUND_UP(SEND_FRAG_SIZE(SSP_MAX_MESSAGE_SIZE), 8), SSP_FRAG_MESSAGES)
+#endif
 #endif
 
+// Maximum number of fixed block pools reported by SSP_GetMemStats()
+#define MAX_MEM_POOLS   8
+
+// Size of the ACK/NAK/SACK SspData memory in 4-byte words
+#define ACK_NAK_DATA_WORDS \
+    ((SSP_DATA_SIZE(MAX_EXT_SIZE + SACK_BITMAP_SIZE) + sizeof(UINT32) - 1) / sizeof(UINT32))
+
 typedef struct
 {
-    // A transaction ID that is incremented on each new message
-    UINT8 sendTransId;
+    // Transaction IDs incremented on each new message. Each source and 
+    // destination socket pair has its own sequence.
+    UINT16 sendTransId[SSP_SOCKET_MAX][SSP_SOCKET_MAX];
 
     // A software lock handle
     SSP_OSAL_HANDLE hSspLock;
@@ -79,17 +458,47 @@ typedef struct
     // Set to TRUE after one time initialization complete
     BOOL initOnce;
 
-    // Linked list head pointers for data to be transmitted grouped by port ID
-    SendData* sendDataListHead[SSP_MAX_PORTS];
+    // Linked lists of data to be transmitted grouped by port ID
+    SendDataList sendDataList[SSP_MAX_PORTS];
+
+    // Queued data to be transmitted for each source and destination socket pair
+    SendDataPair sendDataPair[SSP_SOCKET_MAX][SSP_SOCKET_MAX];
+
+    // Maximum number of unacknowledged messages in flight on each port
+    UINT16 sendWindow[SSP_MAX_PORTS];
+
+    // Received message history for each source and destination socket pair.
+    // Socket IDs are unique on a CPU so the source socket implies the port.
+    ReplayWindow replayWindow[SSP_SOCKET_MAX][SSP_SOCKET_MAX];
+
+    // Received messages held for in order delivery on all ports
+    RecvHold recvHold[MAX_SEND_WINDOW];
+    UINT16 recvHoldCnt;
 
-    // The last received message transaction IDs on each port
-    ReceivedTransId lastReceivedTransId[SSP_MAX_PORTS];
+#ifdef USE_SSP_FRAGMENTATION
+    // Fragmented message reassembly for each destination socket
+    Reassembly reassembly[SSP_SOCKET_MAX];
+#endif
+
+    // Received messages waiting to be acknowledged on each port
+    PendingAck pendingAck[SSP_MAX_PORTS];
+
+    // Round trip time estimate on each port
+    RttEstimate rtt[SSP_MAX_PORTS];
+
+    // Dedicated SspData memory for ACK/NAK/SACK messages sent on each port
+    UINT32 sspDataForAckNakMem[SSP_MAX_PORTS][ACK_NAK_DATA_WORDS];
 
-    // Dedicated memory for ACK/NAK messages
-    UINT8 sspDataForAckNakMem[SSP_DATA_SIZE(0)];
+    // Reserved outgoing messages waiting for SSP_CommitSend() linked by next
+    SendData* reservedList[SSP_MAX_PORTS];
 
-    // Dedicated data structure for ACK/NAK messages
-    SspData* sspDataForAckNak;
+    // Queue entries claimed by reserved messages and messages being built but 
+    // not yet inserted into each port list
+    UINT16 claimedCnt[SSP_MAX_PORTS];
+
+    // Received data passed to the current SSP_RECEIVE callback on each port or 
+    // NULL. Only written by the task processing the port.
+    const SspData* recvCallbackData[SSP_MAX_PORTS];
 } SspComObj;
 
 // Private module data
@@ -97,304 +506,1478 @@ static SspComObj self;
 
 // Private functions
 static SendData* AllocSendData(UINT16 dataSize);
+#ifdef USE_SSP_FRAGMENTATION
+static SendData* AllocFragSendData(UINT16 size);
+#endif
 static void FreeSendData(SendData* sendData);
 static void ListInsert(SspPortId portId, SendData* sendData);
-static void ListErase(SspPortId portId, const SendData* sendData);
+static void ListErase(SspPortId portId, SendData* sendData);
 static SendData* ListFront(SspPortId portId);
-static SendData* ListFind(SspPortId portId, const SspPacketHeader* header);
+static SendData* ListNext(const SendData* sendData);
+static SendData* ListFind(SspPortId portId, const SspPacketHeader* header, UINT16 transId);
 static UINT16 ListSize(SspPortId portId);
-static void SendAck(const SspPacketHeader* headerToAck);
-static void SendNak(const SspPacketHeader* headerToNak);
+static BOOL ClaimQueue(SspPortId portId);
+static void ReleaseQueue(SspPortId portId);
+static UINT16 GetOldestTransId(const SendData* sendData);
+static BOOL InSendWindow(SspPortId portId, const SendData* sendData, UINT16 transId);
+static SspErr SendMessage(SendData* sendData);
+#ifdef USE_SSP_FRAGMENTATION
+static SspErr SendFragment(SendData* sendData, UINT8 index);
+static SspErr SendNextFragments(SspPortId portId, SendData* sendData, UINT16* windowCnt);
+#endif
+static UINT8 GetExtSize(UINT8 type);
+static UINT16 GetTransIdMask(UINT8 type);
+static UINT16 GetTransId(const SspPacket* packet);
+static void SetTransId(SspPacket* packet, UINT16 transId);
+static BOOL GetFragment(const SspPacket* packet, Fragment* fragment);
+static void SetFragment(SspPacket* packet, const Fragment* fragment);
+#ifdef USE_SSP_FRAGMENTATION
+static UINT16 GetFragmentOffset(const Fragment* fragment);
+static UINT16 GetFragmentSize(const Fragment* fragment);
+#endif
+static void SendReply(SspPortId portId, const SspPacketHeader* header, UINT16 transId, 
+    UINT8 type, const UINT8* body, UINT8 bodySize);
+static void SendAck(SspPortId portId, const SspPacketHeader* headerToAck, UINT16 transId);
+static void SendNak(SspPortId portId, const SspPacketHeader* headerToNak, UINT16 transId);
+static void SendSack(SspPortId portId, const PendingAck* pendingAck);
+static void QueueAck(SspPortId portId, const SspPacketHeader* headerToAck, UINT16 transId);
+static void FlushAck(SspPortId portId, BOOL force);
+static void ProcessSack(SspPortId portId, const SspData* sack);
+static void AckSendData(SspPortId portId, SendData* sendData, UINT16 transId);
+static BOOL AckFragment(SspPortId portId, SendData* sendData, UINT16 transId);
+static void NotifySend(SspPortId portId, SendData* sendData, SspErr err);
+static void UpdateRtt(SspPortId portId, UINT32 rtt);
+static UINT32 GetAckTimeout(SspPortId portId, const SendData* sendData);
+static UINT32 GetRetryTimeout(SspPortId portId);
 static SspDataCallback GetCallbackListener(UINT8 socketId);
 static void CallbackListener(UINT8 socketId, const SspData* sspData);
-static void NotifyListener(UINT8 socketId, const SspData* sspData);
+static void CallbackListenerData(UINT8 socketId, const SspData* sspData, 
+    const void* data, UINT16 dataSize);
+static BOOL IsReceived(const ReplayWindow* window, UINT16 transId);
+static void AdvanceNextTransId(ReplayWindow* window);
+static BOOL IsDuplicate(const SspData* sspData);
+static void RecordReceived(const SspData* sspData);
+static BOOL AcceptInOrder(SspPortId portId, const SspData* sspData);
+static BOOL IsHeld(const SspData* sspData, BOOL pair);
+static BOOL HoldReceived(SspPortId portId, const SspData* sspData);
+static void DeliverHeld(SspPortId portId);
+static BOOL AcceptFragment(const SspData* sspData);
+static void Reassemble(UINT8 socketId, const SspData* sspData);
+static void NotifyListener(SspPortId portId, UINT8 socketId, const SspData* sspData);
 static void ProcessSend(SspPortId portId);
-static void ProcessReceive(SspPortId portId);
-
-/// Allocate a SendData structure
+static void ReceivePacket(SspPortId portId);
+static void ProcessReceive(SspPortId portId, UINT16 packetBudget, UINT32 timeBudget);
+static void ProcessPort(SspPortId portId, UINT16 packetBudget, UINT32 timeBudget);
+static BOOL IsSendIdle(void);
+static SendData* FindReserved(const void* data, SspPortId* portId, SendData*** link);
+static void CopyData(UINT8* dest, UINT16 offset, UINT16 size, INT16 numData, 
+    void const** dataArray, const UINT16* dataSizeArray);
+
+/// Allocate a SendData structure and the SspData within the same block.
 /// @param[in] dataSize The data size of the payload.
 /// @return The allocated SendData structure or NULL if fails.
 static SendData* AllocSendData(UINT16 dataSize)
 {    
+    SendData* sendData = NULL;
 #ifdef USE_FB_ALLOCATOR
-    SendData* sendData = (SendData*)ALLOC_Calloc(sendDataAllocator, 1, sizeof(SendData));
+    UINT16 cls;
+
+    // Use the smallest size class with a free block 
+    for (cls = 0; cls < SEND_DATA_CLASSES && !sendData; cls++)
+    {
+        if (dataSize <= sendDataClasses[cls].bodySize)
+        {
+            sendData = (SendData*)ALLOC_TryCalloc(*sendDataClasses[cls].hAlloc, 1, 
+                SEND_DATA_SIZE(dataSize));
+        }
+    }
 #else
-    SendData* sendData = (SendData*)calloc(1, sizeof(SendData));
+    sendData = (SendData*)calloc(1, SEND_DATA_SIZE(dataSize));
 #endif
     if (sendData)
     {
-        // Allocate a SspData structure to hold the required data size
-        sendData->sspData = SSPCOM_AllocateSspData(dataSize);
-        if (!sendData->sspData)
-        {
-            FreeSendData(sendData);
-            sendData = NULL;
-        }
+        // The SspData follows the SendData structure
+        sendData->sspData = (SspData*)((char*)sendData + SEND_DATA_OFFSET);
+        SSPCOM_InitSspData(sendData->sspData, dataSize);
+    }
+
+    return sendData;
+}
+
+#ifdef USE_SSP_FRAGMENTATION
+/// Allocate a fragmented message SendData structure. The SspData sized for one
+/// maximum size fragment and the message data follow within the same block.
+/// @param[in] size The message data size.
+/// @return The allocated SendData structure or NULL if fails.
+static SendData* AllocFragSendData(UINT16 size)
+{
+    SendData* sendData;
+
+#ifdef USE_FB_ALLOCATOR
+    sendData = (SendData*)ALLOC_TryCalloc(sendFragAllocator, 1, SEND_FRAG_SIZE(size));
+#else
+    sendData = (SendData*)calloc(1, SEND_FRAG_SIZE(size));
+#endif
+    if (sendData)
+    {
+        // The SspData follows the SendData structure
+        sendData->sspData = (SspData*)((char*)sendData + SEND_DATA_OFFSET);
+        SSPCOM_InitSspData(sendData->sspData, SSP_MAX_BODY_SIZE);
+
+        // The fragment state and message data follow the SspData
+        sendData->frag = (FragSend*)((char*)sendData + FRAG_SEND_OFFSET);
+        sendData->frag->data = (UINT8*)(sendData->frag + 1);
+        sendData->frag->size = size;
     }
 
     return sendData;
 }
+#endif
 
 /// Free a SendData structure
 /// @param[in] sendData The previously allocated structure to free.
 static void FreeSendData(SendData* sendData)
 {
-    if (sendData)
-    {
-        SSPCOM_DeallocateSspData(sendData->sspData);
 #ifdef USE_FB_ALLOCATOR
-        ALLOC_Free(sendDataAllocator, sendData);
-#else
-        free(sendData);
+    UINT16 cls;
+
+    if (!sendData)
+        return;
+
+#ifdef USE_SSP_FRAGMENTATION
+    if (ALLOC_Contains(sendFragAllocator, sendData))
+    {
+        ALLOC_Free(sendFragAllocator, sendData);
+        return;
+    }
 #endif
+
+    // Return the block to the size class allocator that owns it
+    for (cls = 0; cls < SEND_DATA_CLASSES; cls++)
+    {
+        if (ALLOC_Contains(*sendDataClasses[cls].hAlloc, sendData))
+        {
+            ALLOC_Free(*sendDataClasses[cls].hAlloc, sendData);
+            return;
+        }
     }
+
+    // Block not allocated by AllocSendData()
+    ASSERT();
+#else
+    free(sendData);
+#endif
 }
 
-/// Insert dynamically allocated SendData instance into a list
+/// Assign a transaction ID to a dynamically allocated SendData instance and 
+/// insert it at the end of a list. A fragmented message is assigned one 
+/// consecutive transaction ID per fragment. The queue entry must be claimed 
+/// first using ClaimQueue().
 /// @param[in] portId A port identifier. 
 /// @param[in] sendData The data to insert into the list.
 static void ListInsert(SspPortId portId, SendData* sendData)
 {
-    SendData* msg = NULL;
+    SendDataList* list = &self.sendDataList[portId];
+    SendDataPair* pair;
+    SendData** bucket;
+    SspPacket* packet;
+    Fragment fragment;
 
     ASSERT_TRUE(sendData != NULL);
+    packet = &sendData->sspData->packet;
+    pair = &self.sendDataPair[packet->header.srcId][packet->header.destId];
 
     SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
 
-    // Get head of list
-    msg = self.sendDataListHead[portId];
+    // Get the next transaction ID for this socket pair
+    SetTransId(packet, self.sendTransId[packet->header.srcId][packet->header.destId]);
+    sendData->msgTransId = GetTransId(packet);
 
-    // Head of list NULL?
-    if (NULL == msg)
+    if (GetFragment(packet, &fragment))
     {
-        // Add to head of linked list
-        self.sendDataListHead[portId] = sendData;
-        sendData->next = NULL;
+        // Reserve a transaction ID for each fragment and add the message to 
+        // the fragmented messages
+        self.sendTransId[packet->header.srcId][packet->header.destId] += fragment.count;
+        bucket = &list->fragList;
+        if (NULL == pair->frag)
+            pair->frag = sendData;
     }
     else
     {
-        // Find list tail
-        while (NULL != msg->next)
-        {
-            // Get next structure
-            msg = msg->next;
-        }
+        // Add the message to the transaction ID index bucket
+        self.sendTransId[packet->header.srcId][packet->header.destId]++;
+        bucket = &list->index[TRANS_ID_INDEX(packet->header.transId)];
+    }
+    sendData->indexNext = *bucket;
+    *bucket = sendData;
+
+    // Link the message after the list tail
+    sendData->next = NULL;
+    sendData->prev = list->tail;
+    if (NULL == list->tail)
+        list->head = sendData;
+    else
+        list->tail->next = sendData;
+    list->tail = sendData;
+    list->size++;
+
+    // Link the message after the newest message to the socket pair
+    sendData->pairNext = NULL;
+    sendData->pairPrev = pair->tail;
+    if (NULL == pair->tail)
+        pair->head = sendData;
+    else
+        pair->tail->pairNext = sendData;
+    pair->tail = sendData;
+
+    // The claimed queue entry is now within the list
+    ASSERT_TRUE(self.claimedCnt[portId] > 0);
+    self.claimedCnt[portId]--;
 
-        // Add message to the end of the list
-        msg->next = sendData;
-        sendData->next = NULL;
+    SSPOSAL_LockPut(self.hSspLock);
+} 
+
+/// Remove a SendData instance from the list.
+/// @param[in] portId A port identifier. 
+/// @param[in] sendData The data item to remove. Must be within the list.
+static void ListErase(SspPortId portId, SendData* sendData)
+{
+    SendDataList* list = &self.sendDataList[portId];
+    SendDataPair* pair;
+    SendData** bucket;
+
+    ASSERT_TRUE(sendData != NULL);
+
+    pair = &self.sendDataPair[sendData->sspData->packet.header.srcId]
+        [sendData->sspData->packet.header.destId];
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Unlink the message from the previous element or list head
+    if (NULL == sendData->prev)
+    {
+        ASSERT_TRUE(list->head == sendData);
+        list->head = sendData->next;
+    }
+    else
+    {
+        sendData->prev->next = sendData->next;
+    }
+
+    // Unlink the message from the next element or list tail
+    if (NULL == sendData->next)
+    {
+        ASSERT_TRUE(list->tail == sendData);
+        list->tail = sendData->prev;
+    }
+    else
+    {
+        sendData->next->prev = sendData->prev;
+    }
+
+    sendData->next = NULL;
+    sendData->prev = NULL;
+    list->size--;
+
+    // Remove the message from the fragmented messages or transaction ID index bucket
+    if (sendData->sspData->packet.header.type & SSP_FLAG_FRAG)
+        bucket = &list->fragList;
+    else
+        bucket = &list->index[TRANS_ID_INDEX(sendData->sspData->packet.header.transId)];
+    while (NULL != *bucket && *bucket != sendData)
+        bucket = &(*bucket)->indexNext;
+    ASSERT_TRUE(*bucket == sendData);
+    *bucket = sendData->indexNext;
+    sendData->indexNext = NULL;
+
+    // Find the next fragmented message to the socket pair
+    if (pair->frag == sendData)
+    {
+        pair->frag = sendData->pairNext;
+        while (NULL != pair->frag && !(pair->frag->sspData->packet.header.type & SSP_FLAG_FRAG))
+            pair->frag = pair->frag->pairNext;
+    }
+
+    // Unlink the message from the socket pair messages
+    if (NULL == sendData->pairPrev)
+    {
+        ASSERT_TRUE(pair->head == sendData);
+        pair->head = sendData->pairNext;
+    }
+    else
+    {
+        sendData->pairPrev->pairNext = sendData->pairNext;
+    }
+    if (NULL == sendData->pairNext)
+    {
+        ASSERT_TRUE(pair->tail == sendData);
+        pair->tail = sendData->pairPrev;
+    }
+    else
+    {
+        sendData->pairNext->pairPrev = sendData->pairPrev;
     }
+    sendData->pairNext = NULL;
+    sendData->pairPrev = NULL;
 
     SSPOSAL_LockPut(self.hSspLock);
 } 
 
-/// Remove a SendData instance from the list.
-/// @param[in] portId A port identifier. 
-/// @param[in] sendData The data item to remove. 
-static void ListErase(SspPortId portId, const SendData* sendData)
+/// Get data at the front of the list. 
+/// @param[in] portId A port identifier. 
+/// @return A data instance or NULL if list is empty. 
+static SendData* ListFront(SspPortId portId)
+{
+    SendData* data;
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Get the head list element
+    data = self.sendDataList[portId].head;
+
+    SSPOSAL_LockPut(self.hSspLock);
+    return data;
+}
+
+/// Get the data following an instance within the list. 
+/// @param[in] sendData A data instance within the list.
+/// @return The next data instance or NULL if list end. 
+static SendData* ListNext(const SendData* sendData)
+{
+    SendData* data;
+
+    ASSERT_TRUE(sendData != NULL);
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Get the next list element
+    data = sendData->next;
+
+    SSPOSAL_LockPut(self.hSspLock);
+    return data;
+}
+
+/// Find a SendData instance within the list. 
+/// @param[in] portId A port identifier. 
+/// @param[in] header A received ACK/NAK header with socket IDs to locate the instance.
+/// @param[in] transId The transaction ID to locate. Only the low byte is 
+///     compared unless the header has an extended transaction ID.
+/// @return A data instance or NULL if not found. 
+static SendData* ListFind(SspPortId portId, const SspPacketHeader* header, UINT16 transId)
+{
+    SendData* retVal = NULL;
+    SendData* msg;
+    UINT16 mask;
+
+    ASSERT_TRUE(header != NULL);
+
+    mask = GetTransIdMask(header->type);
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Find the sent SSP message with a matching transaction ID and dest ID. A 
+    // queued message not yet sent may reuse the transaction ID low byte.
+    msg = self.sendDataList[portId].index[TRANS_ID_INDEX(transId)];
+    while (NULL != msg)
+    {
+        if (msg->sendRetries > 0 &&
+            msg->sspData->packet.header.destId == header->srcId &&
+            msg->sspData->packet.header.srcId == header->destId &&
+            ((GetTransId(&msg->sspData->packet) ^ transId) & mask) == 0)
+        {
+            retVal = msg;
+            break;
+        }
+        msg = msg->indexNext;
+    }
+
+#ifdef USE_SSP_FRAGMENTATION
+    // Find the fragmented message with a matching fragment sent
+    for (msg = self.sendDataList[portId].fragList; NULL == retVal && NULL != msg; msg = msg->indexNext)
+    {
+        if (msg->sspData->packet.header.destId == header->srcId &&
+            msg->sspData->packet.header.srcId == header->destId &&
+            ((transId - msg->msgTransId) & mask) < msg->frag->next)
+        {
+            retVal = msg;
+        }
+    }
+#endif
+
+    SSPOSAL_LockPut(self.hSspLock);
+    return retVal;
+} 
+
+/// Get the number of elements within the list. 
+/// @param[in] portId A port identifier. 
+/// @return The number of instances within the list. 
+static UINT16 ListSize(SspPortId portId)
+{
+    UINT16 size;
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+    size = self.sendDataList[portId].size;
+    SSPOSAL_LockPut(self.hSspLock);
+
+    return size;
+}
+
+/// Claim a send queue entry for a message not yet inserted into the list. 
+/// Claimed entries count towards SSP_MAX_MESSAGES until inserted using 
+/// ListInsert() or released using ReleaseQueue().
+/// @param[in] portId A port identifier. 
+/// @return TRUE if claimed. FALSE if the queue is full.
+static BOOL ClaimQueue(SspPortId portId)
+{
+    BOOL claimed = FALSE;
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+    if (self.sendDataList[portId].size + self.claimedCnt[portId] < SSP_MAX_MESSAGES)
+    {
+        self.claimedCnt[portId]++;
+        claimed = TRUE;
+    }
+    SSPOSAL_LockPut(self.hSspLock);
+
+    return claimed;
+}
+
+/// Release a send queue entry claimed using ClaimQueue() but not inserted.
+/// @param[in] portId A port identifier. 
+static void ReleaseQueue(SspPortId portId)
+{
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+    ASSERT_TRUE(self.claimedCnt[portId] > 0);
+    self.claimedCnt[portId]--;
+    SSPOSAL_LockPut(self.hSspLock);
+}
+
+/// Get the size of the extension fields at the start of a packet body.
+/// @param[in] type The packet header type field.
+/// @return The extension fields size in bytes.
+static UINT8 GetExtSize(UINT8 type)
+{
+    UINT8 size = 0;
+
+    if (type & SSP_FLAG_EXT_SEQ)
+        size += 1;
+    if (type & SSP_FLAG_FRAG)
+        size += FRAG_EXT_SIZE;
+
+    return size;
+}
+
+/// Get the mask of valid transaction ID bits.
+/// @param[in] type The packet header type field.
+/// @return 0xFFFF if the packet has an extended transaction ID, otherwise 0xFF.
+static UINT16 GetTransIdMask(UINT8 type)
+{
+    return (type & SSP_FLAG_EXT_SEQ) ? 0xFFFF : 0xFF;
+}
+
+/// Get the packet transaction ID. 
+/// @param[in] packet The packet.
+/// @return The transaction ID including the extended high byte if present.
+static UINT16 GetTransId(const SspPacket* packet)
+{
+    UINT16 transId = packet->header.transId;
+
+    if (packet->header.type & SSP_FLAG_EXT_SEQ)
+        transId |= (UINT16)packet->body[0] << 8;
+
+    return transId;
+}
+
+/// Set the packet transaction ID. The header type and body must already be set.
+/// @param[in] packet The packet.
+/// @param[in] transId The transaction ID.
+static void SetTransId(SspPacket* packet, UINT16 transId)
+{
+    packet->header.transId = (UINT8)transId;
+
+    if (packet->header.type & SSP_FLAG_EXT_SEQ)
+        packet->body[0] = (UINT8)(transId >> 8);
+}
+
+/// Get the packet fragment extension fields. 
+/// @param[in] packet The packet.
+/// @param[out] fragment The fragment extension fields.
+/// @return TRUE if the packet is a message fragment.
+static BOOL GetFragment(const SspPacket* packet, Fragment* fragment)
+{
+    const UINT8* ext;
+
+    if (!(packet->header.type & SSP_FLAG_FRAG))
+        return FALSE;
+
+    // Fragment fields follow the extension fields of higher flags
+    ext = &packet->body[GetExtSize(packet->header.type & SSP_FLAG_EXT_SEQ)];
+    fragment->size = (UINT16)(ext[0] | (ext[1] << 8));
+    fragment->index = ext[2];
+    fragment->count = ext[3];
+    return TRUE;
+}
+
+/// Set the packet fragment extension fields. The header type must already be set.
+/// @param[in] packet The packet.
+/// @param[in] fragment The fragment extension fields.
+static void SetFragment(SspPacket* packet, const Fragment* fragment)
+{
+    UINT8* ext = &packet->body[GetExtSize(packet->header.type & SSP_FLAG_EXT_SEQ)];
+
+    // Message size is sent little-endian
+    ext[0] = (UINT8)fragment->size;
+    ext[1] = (UINT8)(fragment->size >> 8);
+    ext[2] = fragment->index;
+    ext[3] = fragment->count;
+}
+
+#ifdef USE_SSP_FRAGMENTATION
+/// Get the fragment data offset within the message.
+/// @param[in] fragment The fragment extension fields.
+/// @return The offset in bytes.
+static UINT16 GetFragmentOffset(const Fragment* fragment)
+{
+    return fragment->index * ((fragment->size + fragment->count - 1) / fragment->count);
+}
+
+/// Get the fragment data size.
+/// @param[in] fragment The fragment extension fields. 
+/// @return The fragment data size in bytes or 0 if the fields are invalid.
+static UINT16 GetFragmentSize(const Fragment* fragment)
+{
+    UINT16 offset;
+
+    if (fragment->count == 0 || fragment->index >= fragment->count)
+        return 0;
+
+    // All fragments except the last are the same size
+    if (fragment->index < fragment->count - 1)
+        return (fragment->size + fragment->count - 1) / fragment->count;
+
+    offset = GetFragmentOffset(fragment);
+    if (offset >= fragment->size)
+        return 0;
+    return fragment->size - offset;
+}
+#endif
+
+/// Send an ACK, NAK or SACK reply message. The reply uses the same transaction 
+/// ID format as the message being replied to. 
+/// @param[in] portId The port to send the reply on. 
+/// @param[in] header The header of the message to reply to. 
+/// @param[in] transId The transaction ID to reply with.
+/// @param[in] type The reply message type.
+/// @param[in] body The reply body data or NULL.
+/// @param[in] bodySize The reply body data size.
+static void SendReply(SspPortId portId, const SspPacketHeader* header, UINT16 transId, 
+    UINT8 type, const UINT8* body, UINT8 bodySize)
+{
+    // Each port has its own reply data so ports may be processed concurrently
+    SspData* sspDataForAckNak = (SspData*)self.sspDataForAckNakMem[portId];
+    UINT8 flags;
+    UINT8 extSize;
+
+    ASSERT_TRUE(header != NULL);
+
+    flags = header->type & SSP_FLAG_EXT_SEQ;
+    extSize = GetExtSize(flags);
+
+    SSPCOM_InitSspData(sspDataForAckNak, extSize + bodySize);
+    sspDataForAckNak->err = SSP_SUCCESS;
+    sspDataForAckNak->type = SSP_SEND;
+    sspDataForAckNak->packet.header.srcId = header->destId; // dest now src
+    sspDataForAckNak->packet.header.destId = header->srcId; // src now dest
+    sspDataForAckNak->packet.header.bodySize = extSize + bodySize;
+    sspDataForAckNak->packet.header.type = type | flags;
+    SetTransId(&sspDataForAckNak->packet, transId);
+    if (bodySize > 0)
+        memcpy(&sspDataForAckNak->packet.body[extSize], body, bodySize);
+
+    // Send the reply message on the port the message arrived
+    SSPCOM_SendPort(portId, sspDataForAckNak);
+}
+
+/// Send an ACK message.
+/// @param[in] portId The port to send the ACK on. 
+/// @param[in] headerToAck The header of a message to acknowledge. 
+/// @param[in] transId The transaction ID of the message to acknowledge. 
+static void SendAck(SspPortId portId, const SspPacketHeader* headerToAck, UINT16 transId)
+{
+    SendReply(portId, headerToAck, transId, MSG_TYPE_ACK, NULL, 0);
+} 
+
+/// Send an NAK message.
+/// @param[in] portId The port to send the NAK on. 
+/// @param[in] headerToNak The header of a message to negative acknowledge. 
+/// @param[in] transId The transaction ID of the message to negative acknowledge. 
+static void SendNak(SspPortId portId, const SspPacketHeader* headerToNak, UINT16 transId)
+{
+    SendReply(portId, headerToNak, transId, MSG_TYPE_NAK, NULL, 0);
+} 
+
+/// Send a selective ACK message acknowledging multiple messages at once.
+/// @param[in] portId The port to send the SACK on. 
+/// @param[in] pendingAck The messages to acknowledge. 
+static void SendSack(SspPortId portId, const PendingAck* pendingAck)
+{
+    UINT8 bitmap[SACK_BITMAP_SIZE];
+    UINT16 i;
+
+    ASSERT_TRUE(pendingAck != NULL);
+
+    // Bitmap is sent little-endian
+    for (i = 0; i < SACK_BITMAP_SIZE; i++)
+        bitmap[i] = (UINT8)(pendingAck->bitmap >> (i * 8));
+
+    SendReply(portId, &pendingAck->header, pendingAck->transId, MSG_TYPE_SACK, bitmap, SACK_BITMAP_SIZE);
+}
+
+/// Add a received message to the port pending ACK. Messages between the same
+/// sockets are combined and acknowledged later by FlushAck().
+/// @param[in] portId A port identifier. 
+/// @param[in] headerToAck The header of a message to acknowledge. 
+/// @param[in] transId The transaction ID of the message to acknowledge. 
+static void QueueAck(SspPortId portId, const SspPacketHeader* headerToAck, UINT16 transId)
+{
+    PendingAck* pendingAck = &self.pendingAck[portId];
+    UINT16 mask;
+    UINT16 offset;
+    UINT16 newer;
+
+    ASSERT_TRUE(headerToAck != NULL);
+
+    if (pendingAck->pending)
+    {
+        // Different sockets or transaction ID format than the pending ACK? 
+        // Send pending ACK first.
+        if (pendingAck->header.srcId != headerToAck->srcId ||
+            pendingAck->header.destId != headerToAck->destId ||
+            GetTransIdMask(pendingAck->header.type) != GetTransIdMask(headerToAck->type))
+        {
+            FlushAck(portId, TRUE);
+        }
+        else
+        {
+            // Compute distance from newest pending transId (modulo 256 or 65536)
+            mask = GetTransIdMask(headerToAck->type);
+            newer = (transId - pendingAck->transId) & mask;
+            offset = (pendingAck->transId - transId) & mask;
+
+            if (newer == 0)
+            {
+                // Already waiting to be acknowledged
+                return;
+            }
+            else if (newer <= (mask >> 1) && pendingAck->span + newer <= SACK_BITMAP_BITS)
+            {
+                // Newer message. Shift bitmap so the previous newest becomes an older bit.
+                pendingAck->bitmap = (newer < SACK_BITMAP_BITS) ? pendingAck->bitmap << newer : 0;
+                pendingAck->bitmap |= (UINT32)1 << (newer - 1);
+                pendingAck->header = *headerToAck;
+                pendingAck->transId = transId;
+                pendingAck->span += (UINT8)newer;
+                return;
+            }
+            else if (newer > (mask >> 1) && offset <= SACK_BITMAP_BITS)
+            {
+                // Older message within the bitmap
+                pendingAck->bitmap |= (UINT32)1 << (offset - 1);
+                if (offset > pendingAck->span)
+                    pendingAck->span = (UINT8)offset;
+                return;
+            }
+            else
+            {
+                // Outside the bitmap range. Send pending ACK first.
+                FlushAck(portId, TRUE);
+            }
+        }
+    }
+
+    // Start a new pending ACK
+    pendingAck->pending = TRUE;
+    pendingAck->header = *headerToAck;
+    pendingAck->transId = transId;
+    pendingAck->span = 0;
+    pendingAck->tickStamp = SSPOSAL_GetTickCount();
+    pendingAck->bitmap = 0;
+}
+
+/// Send the port pending ACK. A single message is acknowledged with an ACK 
+/// message, multiple messages with one SACK message.
+/// @param[in] portId A port identifier. 
+/// @param[in] force TRUE to send now, FALSE to send only if SSP_ACK_DELAY expired.
+static void FlushAck(SspPortId portId, BOOL force)
+{
+    PendingAck* pendingAck = &self.pendingAck[portId];
+
+    if (!pendingAck->pending)
+        return;
+
+#if (SSP_ACK_DELAY > 0)
+    if (!force && SSPOSAL_GetTickCount() - pendingAck->tickStamp < SSP_ACK_DELAY)
+        return;
+#else
+    (void)force;
+#endif
+
+    if (pendingAck->span == 0)
+        SendAck(portId, &pendingAck->header, pendingAck->transId);
+    else
+        SendSack(portId, pendingAck);
+
+    pendingAck->pending = FALSE;
+}
+
+/// Complete every outgoing message acknowledged by a SACK message. 
+/// @param[in] portId A port identifier. 
+/// @param[in] sack The received SACK message. 
+static void ProcessSack(SspPortId portId, const SspData* sack)
+{
+    SendData* sendData;
+    const UINT8* bitmap;
+    UINT16 transId;
+    INT16 offset;
+    INT16 bits;
+
+    ASSERT_TRUE(sack != NULL);
+
+    transId = GetTransId(&sack->packet);
+    bitmap = &sack->packet.body[GetExtSize(sack->packet.header.type)];
+    bits = (INT16)(sack->packet.header.bodySize - GetExtSize(sack->packet.header.type)) * 8;
+    if (bits > (INT16)SACK_BITMAP_BITS)
+        bits = (INT16)SACK_BITMAP_BITS;
+
+    // Complete oldest to newest. Bit (offset - 1) acknowledges transId - offset
+    // and the header transId is always acknowledged.
+    for (offset = bits; offset >= 0; offset--)
+    {
+        if (offset > 0 && !((bitmap[(offset - 1) / 8] >> ((offset - 1) % 8)) & 1))
+            continue;
+
+        // Find the SendData instance associated with this transId
+        sendData = ListFind(portId, &sack->packet.header, (UINT16)(transId - offset));
+        if (NULL != sendData)
+            AckSendData(portId, sendData, (UINT16)(transId - offset));
+    }
+}
+
+/// Complete an acknowledged outgoing message. The client is notified and the 
+/// message is removed from the list.
+/// @param[in] portId A port identifier. 
+/// @param[in] sendData The acknowledged message.
+/// @param[in] transId The acknowledged transaction ID.
+static void AckSendData(SspPortId portId, SendData* sendData, UINT16 transId)
+{
+    ASSERT_TRUE(sendData != NULL);
+
+    if (sendData->sspData->packet.header.type & SSP_FLAG_FRAG)
+    {
+        // Message complete once every fragment is acknowledged
+        if (AckFragment(portId, sendData, transId) == FALSE)
+            return;
+    }
+    else if (sendData->sendRetries == 1)
+    {
+        // Measure round trip time only if sent once (Karn's algorithm). The ACK
+        // of a retried message is ambiguous as to which transmission it matches.
+        UpdateRtt(portId, SSPOSAL_GetTickCount() - sendData->sendTickStamp);
+    }
+
+    // Let client know remote CPU accepted the message
+    NotifySend(portId, sendData, SSP_SUCCESS);
+
+    // Free allocated memory
+    ListErase(portId, sendData);
+    FreeSendData(sendData);
+}
+
+/// Record an acknowledged fragment of an outgoing fragmented message. 
+/// @param[in] portId A port identifier. 
+/// @param[in] sendData A fragmented message within the list.
+/// @param[in] transId The acknowledged fragment transaction ID.
+/// @return TRUE if every fragment of the message is acknowledged.
+static BOOL AckFragment(SspPortId portId, SendData* sendData, UINT16 transId)
+{
+#ifdef USE_SSP_FRAGMENTATION
+    FragSend* frag = sendData->frag;
+    UINT16 index;
+
+    ASSERT_TRUE(frag != NULL);
+
+    index = (transId - sendData->msgTransId) & 
+        GetTransIdMask(sendData->sspData->packet.header.type);
+    if (index >= frag->next || FRAG_BIT_GET(frag->acked, index))
+        return FALSE;
+    FRAG_BIT_SET(frag->acked, index);
+
+    // Measure round trip time using the newest fragment if sent once
+    if (frag->rttSample && index == frag->next - 1)
+    {
+        UpdateRtt(portId, SSPOSAL_GetTickCount() - sendData->sendTickStamp);
+        frag->rttSample = FALSE;
+    }
+
+    // Oldest fragment acknowledged? Advance the window. The retries restart 
+    // since the remote CPU is receiving the message.
+    if (index == frag->base)
+    {
+        while (frag->base < frag->count && FRAG_BIT_GET(frag->acked, frag->base))
+            frag->base++;
+        sendData->sendRetries = 1;
+    }
+
+    return frag->base == frag->count;
+#else
+    (void)portId;
+    (void)sendData;
+    (void)transId;
+    return TRUE;
+#endif
+}
+
+/// Notify the registered client of an outgoing message success or failure.
+/// @param[in] portId The port the message was sent on. 
+/// @param[in] sendData The outgoing message.
+/// @param[in] err The message result.
+static void NotifySend(SspPortId portId, SendData* sendData, SspErr err)
+{
+    ASSERT_TRUE(sendData != NULL);
+
+    sendData->sspData->err = err;
+
+#ifdef USE_SSP_FRAGMENTATION
+    // Client gets the whole fragmented message, not the last fragment sent
+    if (NULL != sendData->frag)
+    {
+        CallbackListenerData(sendData->sspData->packet.header.srcId, sendData->sspData,
+            sendData->frag->data, sendData->frag->size);
+        return;
+    }
+#endif
+
+    NotifyListener(portId, sendData->sspData->packet.header.srcId, sendData->sspData);
+}
+
+/// Update the port round trip time estimate and ACK timeout using a new 
+/// measurement. Computed per RFC 6298 using integer math.
+/// @param[in] portId A port identifier. 
+/// @param[in] rtt The measured round trip time in mS.
+static void UpdateRtt(SspPortId portId, UINT32 rtt)
+{
+    RttEstimate* est = &self.rtt[portId];
+    INT32 delta;
+    UINT32 timeout;
+
+    if (!est->valid)
+    {
+        // First measurement: SRTT = R, RTTVAR = R/2
+        est->valid = TRUE;
+        est->srtt = (INT32)rtt << 3;
+        est->rttvar = (INT32)rtt << 1;
+    }
+    else
+    {
+        // SRTT = 7/8 SRTT + 1/8 R, RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|
+        delta = (INT32)rtt - (est->srtt >> 3);
+        est->srtt += delta;
+        if (delta < 0)
+            delta = -delta;
+        est->rttvar += delta - (est->rttvar >> 2);
+    }
+
+    // Timeout = SRTT + 4 * RTTVAR
+    timeout = (UINT32)((est->srtt >> 3) + est->rttvar);
+    if (timeout < SSP_ACK_TIMEOUT_MIN)
+        timeout = SSP_ACK_TIMEOUT_MIN;
+    else if (timeout > SSP_ACK_TIMEOUT_MAX)
+        timeout = SSP_ACK_TIMEOUT_MAX;
+    est->ackTimeout = timeout;
+}
+
+/// Get the ACK timeout for an outgoing message. The port timeout is doubled
+/// on each retry up to SSP_ACK_TIMEOUT_MAX. 
+/// @param[in] portId A port identifier. 
+/// @param[in] sendData The outgoing message.
+/// @return The ACK timeout in mS.
+static UINT32 GetAckTimeout(SspPortId portId, const SendData* sendData)
+{
+    UINT32 timeout = self.rtt[portId].ackTimeout;
+    UINT32 retry;
+
+    for (retry = 1; retry < sendData->sendRetries && timeout < SSP_ACK_TIMEOUT_MAX; retry++)
+        timeout <<= 1;
+
+    if (timeout > SSP_ACK_TIMEOUT_MAX)
+        timeout = SSP_ACK_TIMEOUT_MAX;
+    return timeout;
+}
+
+/// Get the time a sender retries a message before the retries are exhausted. 
+/// The port ACK timeout estimates the remote sender ACK timeout on the same link.
+/// @param[in] portId A port identifier. 
+/// @return The sum of the ACK timeouts of every send attempt in mS.
+static UINT32 GetRetryTimeout(SspPortId portId)
+{
+    UINT32 timeout = self.rtt[portId].ackTimeout;
+    UINT32 total = 0;
+    UINT32 retry;
+
+    for (retry = 0; retry <= SSP_MAX_RETRIES; retry++)
+    {
+        total += timeout;
+        timeout <<= 1;
+        if (timeout > SSP_ACK_TIMEOUT_MAX)
+            timeout = SSP_ACK_TIMEOUT_MAX;
+    }
+    return total;
+}
+
+/// Get the registered listener callback function
+/// @param[in] socketId A socket ID.
+/// @return The callback function for the socket ID.
+static SspDataCallback GetCallbackListener(UINT8 socketId)
+{
+    SspDataCallback callback;
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Get the registered callback listener for the socket
+    callback = self.socketToCallbackMap[socketId];
+
+    SSPOSAL_LockPut(self.hSspLock);
+
+    return callback;
+}
+
+/// Callback the registered listener function pointer with the packet client data. 
+/// @param[in] socketId The socket identifier. 
+/// @param[in] sspData The data used in the notification. 
+static void CallbackListener(UINT8 socketId, const SspData* sspData)
+{
+    UINT8 extSize;
+
+    ASSERT_TRUE(sspData != NULL);
+
+    // Client data follows any extension fields
+    extSize = GetExtSize(sspData->packet.header.type);
+
+    CallbackListenerData(socketId, sspData, sspData->packet.body + extSize,
+        (UINT16)(sspData->packet.header.bodySize - extSize));
+} 
+
+/// Callback the registered listener function pointer. 
+/// @param[in] socketId The socket identifier. 
+/// @param[in] sspData The data used in the notification. 
+/// @param[in] data The client data.
+/// @param[in] dataSize The client data size.
+static void CallbackListenerData(UINT8 socketId, const SspData* sspData, 
+    const void* data, UINT16 dataSize)
+{
+    SspDataCallback callback;
+
+    ASSERT_TRUE(sspData != NULL);
+
+    callback = GetCallbackListener(socketId);
+
+    // Is a callback registered?
+    if (NULL != callback)
+    {
+        // Callback client function with the received data
+        callback(
+                socketId,
+                data,
+                dataSize,
+                sspData->type,
+                sspData->err,
+                self.socketToUserDataMap[socketId]);
+    }
+} 
+
+/// Check whether a transaction ID is within the replay window and received. 
+/// Caller must hold the lock.
+/// @param[in] window The replay window of a socket pair.
+/// @param[in] transId The transaction ID.
+/// @return TRUE if a message with the transaction ID was received.
+static BOOL IsReceived(const ReplayWindow* window, UINT16 transId)
+{
+    UINT16 offset;
+
+    // Compute distance behind the newest received transId
+    offset = (window->transId - transId) & window->mask;
+
+    if (offset == 0)
+        return TRUE;
+    else if (offset <= REPLAY_WINDOW_BITS)
+        return (window->bitmap >> (offset - 1)) & 1;
+    else
+        return FALSE;
+}
+
+/// Check whether a received data message is a duplicate of a message already 
+/// received. Each socket pair tracks the newest transaction ID and a bitmap of 
+/// older IDs so retransmissions of any message still in flight are detected. 
+/// Caller must hold the lock.
+/// @param[in] sspData The received data message.
+/// @return TRUE if the message was already received. 
+static BOOL IsDuplicate(const SspData* sspData)
+{
+    const ReplayWindow* window;
+    UINT16 transId;
+    UINT16 mask;
+
+    ASSERT_TRUE(sspData != NULL);
+
+    transId = GetTransId(&sspData->packet);
+    mask = GetTransIdMask(sspData->packet.header.type);
+    window = &self.replayWindow[sspData->packet.header.srcId][sspData->packet.header.destId];
+
+    if (window->valid == FALSE || window->mask != mask)
+        return FALSE;
+
+    // A matching transaction ID with a different CRC is new data
+    if (window->crc[transId % REPLAY_WINDOW_BITS] != (UINT16)sspData->crc)
+        return FALSE;
+
+    return IsReceived(window, transId);
+}
+
+/// Record a received data message within the replay window. A message older 
+/// than the window, or one that is not a duplicate but matches a received 
+/// transaction ID, is new data from a restarted sender and resets the window. 
+/// Caller must hold the lock.
+/// @param[in] sspData The received data message.
+static void RecordReceived(const SspData* sspData)
+{
+    ReplayWindow* window;
+    UINT16 transId;
+    UINT16 mask;
+    UINT16 newer;
+    UINT16 offset;
+    UINT64 bit;
+
+    ASSERT_TRUE(sspData != NULL);
+
+    transId = GetTransId(&sspData->packet);
+    mask = GetTransIdMask(sspData->packet.header.type);
+    window = &self.replayWindow[sspData->packet.header.srcId][sspData->packet.header.destId];
+
+    // Compute distance from newest received transId
+    newer = (transId - window->transId) & mask;
+    offset = (window->transId - transId) & mask;
+
+    if (window->valid && window->mask == mask && newer != 0 && newer <= (mask >> 1))
+    {
+        // Newer message. Shift bitmap so the previous newest becomes an older bit.
+        if (newer <= REPLAY_WINDOW_BITS)
+            window->bitmap = ((newer < REPLAY_WINDOW_BITS) ? window->bitmap << newer : 0) | 
+                ((UINT64)1 << (newer - 1));
+        else
+            window->bitmap = 0;
+        window->transId = transId;
+    }
+    else if (window->valid && window->mask == mask && newer != 0 && 
+             offset <= REPLAY_WINDOW_BITS && !((window->bitmap >> (offset - 1)) & 1))
+    {
+        // Older message within the window not yet received
+        bit = (UINT64)1 << (offset - 1);
+        window->bitmap |= bit;
+    }
+    else
+    {
+        // Start a new window at this message
+        window->valid = TRUE;
+        window->mask = mask;
+        window->transId = transId;
+        window->bitmap = 0;
+        window->nextTransId = transId;
+    }
+
+    window->crc[transId % REPLAY_WINDOW_BITS] = (UINT16)sspData->crc;
+
+    AdvanceNextTransId(window);
+}
+
+/// Advance the next expected transaction ID of a socket pair past the received
+/// messages. Caller must hold the lock.
+/// @param[in] window The replay window of a socket pair.
+static void AdvanceNextTransId(ReplayWindow* window)
+{
+    while (IsReceived(window, window->nextTransId))
+    {
+        window->nextTransId = (window->nextTransId + 1) & window->mask;
+        window->gap = FALSE;
+    }
+}
+
+/// Check whether a received data message is in order. A message is accepted 
+/// once every older message from the source socket is received, so messages 
+/// are delivered in the order sent. A newer message is held using 
+/// HoldReceived(). A missing message the sender failed is skipped after the 
+/// sender retry time, or once a newer message is further ahead than the 
+/// largest send window. With a port send window of 1 the sender only moves on
+/// once a message fails, so a missing message is skipped at once.
+/// @param[in] portId The port the message was received on.
+/// @param[in] sspData The received data message.
+/// @return TRUE if the message is in order, a fragment of the next message, 
+///     older or a duplicate.
+static BOOL AcceptInOrder(SspPortId portId, const SspData* sspData)
 {
-    SendData* currData = NULL;
-    SendData* prevData = NULL;
+    ReplayWindow* window;
+    Fragment fragment;
+    UINT16 transId;
+    UINT16 mask;
+    UINT16 ahead;
+    BOOL accept = TRUE;
 
-    ASSERT_TRUE(sendData != NULL);
+    ASSERT_TRUE(sspData != NULL);
+
+    transId = GetTransId(&sspData->packet);
+    mask = GetTransIdMask(sspData->packet.header.type);
+    window = &self.replayWindow[sspData->packet.header.srcId][sspData->packet.header.destId];
+
+    // A fragment index of 0 is the first fragment of a message
+    if (GetFragment(&sspData->packet, &fragment) == FALSE)
+        fragment.index = 0;
 
     SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
 
-    currData = self.sendDataListHead[portId];
-    prevData = NULL;
-    while (NULL != currData)
+    if (window->valid && window->mask == mask && !IsDuplicate(sspData))
     {
-        // Is this the SendData to remove from list?
-        if (currData->sspData->packet.header.transId == sendData->sspData->packet.header.transId &&
-            currData->sspData->packet.header.destId == sendData->sspData->packet.header.destId &&
-            currData->sspData->packet.header.srcId == sendData->sspData->packet.header.srcId &&
-            currData->sspData->packet.header.type == sendData->sspData->packet.header.type &&
-            currData->sspData->packet.header.checksum == sendData->sspData->packet.header.checksum &&
-            currData->sspData->packet.header.bodySize == sendData->sspData->packet.header.bodySize)
+        // Compute distance ahead of the next expected transId
+        ahead = (transId - window->nextTransId) & mask;
+
+        // Further ahead than the largest send window? The sender failed the 
+        // missing messages before the send window ending at this message.
+        if (ahead >= REPLAY_WINDOW_BITS && ahead <= (mask >> 1))
         {
-            // Unlink the current message from the linked list
-            if (prevData == NULL)
-            {
-                self.sendDataListHead[portId] = currData->next;
-            }
-            else
+            window->nextTransId = (transId - (REPLAY_WINDOW_BITS - 1)) & mask;
+            window->gap = FALSE;
+            AdvanceNextTransId(window);
+            ahead = (transId - window->nextTransId) & mask;
+        }
+
+        if (ahead > (mask >> 1))
+        {
+            // Older message
+        }
+        else if (ahead <= fragment.index)
+        {
+            // Next message or a fragment of the next message
+            window->gap = FALSE;
+        }
+        else if (self.sendWindow[portId] <= 1 || (window->gap && !IsHeld(sspData, TRUE) &&
+                 SSPOSAL_GetTickCount() - window->gapTickStamp > GetRetryTimeout(portId)))
+        {
+            // Sender failed the missing messages. Skip to this message. Held 
+            // messages are skipped to by DeliverHeld() instead.
+            window->nextTransId = (transId - fragment.index) & mask;
+            window->gap = FALSE;
+        }
+        else
+        {
+            // Missing an older message. Start timing the gap.
+            accept = FALSE;
+            if (window->gap == FALSE)
             {
-                prevData->next = currData->next;
+                window->gap = TRUE;
+                window->gapTickStamp = SSPOSAL_GetTickCount();
             }
-            break;
         }
-        prevData = currData;
-        currData = currData->next;
     }
 
     SSPOSAL_LockPut(self.hSspLock);
-} 
+    return accept;
+}
 
-/// Get data at the front of the list. 
-/// @param[in] portId A port identifier. 
-/// @return A data instance or NULL if list is empty. 
-static SendData* ListFront(SspPortId portId)
+/// Check whether a received data message is held. Caller must hold the lock.
+/// @param[in] sspData The received data message.
+/// @param[in] pair TRUE to check for any message held from the socket pair.
+/// @return TRUE if the message, or with pair TRUE any message from the same 
+///     source and destination sockets, is held.
+static BOOL IsHeld(const SspData* sspData, BOOL pair)
 {
-    SendData* data;
+    const SspPacketHeader* header;
+    UINT16 i;
 
-    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
-
-    // Get the head list element
-    data = self.sendDataListHead[portId];
+    ASSERT_TRUE(sspData != NULL);
 
-    SSPOSAL_LockPut(self.hSspLock);
-    return data;
+    for (i = 0; i < self.recvHoldCnt; i++)
+    {
+        header = &self.recvHold[i].sspData->packet.header;
+        if (header->srcId == sspData->packet.header.srcId &&
+            header->destId == sspData->packet.header.destId &&
+            (pair || GetTransId(&self.recvHold[i].sspData->packet) == 
+                GetTransId(&sspData->packet)))
+            return TRUE;
+    }
+    return FALSE;
 }
 
-/// Find a SendData instance within the list. 
-/// @param[in] portId A port identifier. 
-/// @param[in] header A header with data populated to locate the instance.
-/// @return A data instance or NULL if not found. 
-static SendData* ListFind(SspPortId portId, const SspPacketHeader* header)
+/// Hold a received data message that arrived ahead of an older message. The 
+/// port receive buffer is retained so the message is delivered without a copy
+/// once the older messages arrive. 
+/// @param[in] portId The port the message was received on.
+/// @param[in] sspData The received data message rejected by AcceptInOrder().
+/// @return TRUE if the message is held and may be acknowledged. FALSE if no 
+///     receive buffer is available or the message is a fragment, and the 
+///     message is delivered out of order.
+static BOOL HoldReceived(SspPortId portId, const SspData* sspData)
 {
-    SendData* retVal = NULL;
-    SendData* msg;
+    SspData* retained;
+    BOOL held;
 
-    ASSERT_TRUE(header != NULL);
+    ASSERT_TRUE(sspData != NULL);
+
+    // Fragments are reassembled in place and not held
+    if (sspData->packet.header.type & SSP_FLAG_FRAG)
+        return FALSE;
 
     SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
 
-    // Find the SSP message with a matching transaction ID and dest ID
-    msg = self.sendDataListHead[portId];
-    while (NULL != msg)
+    // Retransmission of a held message? Acknowledge it again.
+    held = IsHeld(sspData, FALSE);
+    if (held == FALSE && self.recvHoldCnt < MAX_SEND_WINDOW)
     {
-        if (msg->sspData->packet.header.destId == header->srcId &&
-            msg->sspData->packet.header.srcId == header->destId &&
-            msg->sspData->packet.header.transId == header->transId)
+        // Take the receive buffer from the port parser
+        retained = SSPCOM_RetainRecvData(portId, sspData);
+        if (NULL != retained)
         {
-            retVal = msg;
-            break;
+            self.recvHold[self.recvHoldCnt].sspData = retained;
+            self.recvHold[self.recvHoldCnt].portId = portId;
+            self.recvHoldCnt++;
+            held = TRUE;
         }
-        msg = msg->next;
     }
 
     SSPOSAL_LockPut(self.hSspLock);
-    return retVal;
-} 
+    return held;
+}
 
-/// Get the number of elements within the list. 
-/// @param[in] portId A port identifier. 
-/// @return The number of instances within the list. 
-static UINT16 ListSize(SspPortId portId)
+/// Deliver held messages on a port that are now in order, oldest first. Once 
+/// the missing message is overdue by the sender retry time the oldest held 
+/// message from the socket pair is delivered instead.
+/// @param[in] portId A port identifier.
+static void DeliverHeld(SspPortId portId)
 {
-    UINT16 size = 0;
-    SendData* data;
+    ReplayWindow* window;
+    const SspPacketHeader* header;
+    SspData* sspData;
+    UINT16 transId;
+    UINT16 mask;
+    UINT16 ahead;
+    UINT16 order;
+    UINT16 oldestOrder = 0;
+    INT16 oldest;
+    UINT16 i;
+
+    for (;;)
+    {
+        oldest = -1;
+        sspData = NULL;
 
-    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+        SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
 
-    // Count the number of SendData pointers in the list
-    data = self.sendDataListHead[portId];
-    while (NULL != data)
-    {
-        size++;
-        data = data->next;
-    }
+        // Find the oldest held message that may be delivered
+        for (i = 0; i < self.recvHoldCnt; i++)
+        {
+            if (self.recvHold[i].portId != portId)
+                continue;
 
-    SSPOSAL_LockPut(self.hSspLock);
-    return size;
-}
+            header = &self.recvHold[i].sspData->packet.header;
+            transId = GetTransId(&self.recvHold[i].sspData->packet);
+            mask = GetTransIdMask(header->type);
+            window = &self.replayWindow[header->srcId][header->destId];
+            ahead = (transId - window->nextTransId) & mask;
 
-/// Send an ACK message.
-/// @param[in] headerToAck The header of a message to acknowledge. 
-static void SendAck(const SspPacketHeader* headerToAck)
-{
-    ASSERT_TRUE(headerToAck != NULL);
+            // Order older messages first, then the next message, then newer messages
+            order = (ahead + (mask >> 1) + 1) & mask;
 
-    if (NULL != self.sspDataForAckNak)
-    {
-        self.sspDataForAckNak->err = SSP_SUCCESS;
-        self.sspDataForAckNak->type = SSP_SEND;
-        self.sspDataForAckNak->packet.header.srcId = headerToAck->destId; // dest now src
-        self.sspDataForAckNak->packet.header.destId = headerToAck->srcId; // src now dest
-        self.sspDataForAckNak->packet.header.bodySize = 0;
-        self.sspDataForAckNak->packet.header.transId = headerToAck->transId;  // respond with same transId
-        self.sspDataForAckNak->packet.header.type = MSG_TYPE_ACK;
+            // Source socket restarted? Deliver first.
+            if (window->valid == FALSE || window->mask != mask)
+                order = 0;
 
-        // Send the ACK message
-        SSPCOM_Send(self.sspDataForAckNak);
-    }
-} 
+            // Newer message waiting for a missing message? 
+            else if (ahead != 0 && ahead <= (mask >> 1) && !(window->gap && 
+                     SSPOSAL_GetTickCount() - window->gapTickStamp > GetRetryTimeout(portId)))
+            {
+                // Start timing the gap
+                if (window->gap == FALSE)
+                {
+                    window->gap = TRUE;
+                    window->gapTickStamp = SSPOSAL_GetTickCount();
+                }
+                continue;
+            }
 
-/// Send an NAK message.
-/// @param[in] headerToAck The header of a message to negative acknowledge. 
-static void SendNak(const SspPacketHeader* headerToNak)
-{
-    ASSERT_TRUE(headerToNak != NULL);
+            if (oldest < 0 || order < oldestOrder)
+            {
+                oldest = (INT16)i;
+                oldestOrder = order;
+            }
+        }
 
-    if (NULL != self.sspDataForAckNak)
-    {
-        self.sspDataForAckNak->err = SSP_SUCCESS;
-        self.sspDataForAckNak->type = SSP_SEND;
-        self.sspDataForAckNak->packet.header.srcId = headerToNak->destId; // dest now src
-        self.sspDataForAckNak->packet.header.destId = headerToNak->srcId; // src now dest
-        self.sspDataForAckNak->packet.header.bodySize = 0;
-        self.sspDataForAckNak->packet.header.transId = headerToNak->transId;  // respond with same transId
-        self.sspDataForAckNak->packet.header.type = MSG_TYPE_NAK;
+        if (oldest >= 0)
+        {
+            // Remove the message from the held messages
+            sspData = self.recvHold[oldest].sspData;
+            self.recvHold[oldest] = self.recvHold[--self.recvHoldCnt];
+
+            // Missing messages overdue? Skip to the held message.
+            header = &sspData->packet.header;
+            transId = GetTransId(&sspData->packet);
+            window = &self.replayWindow[header->srcId][header->destId];
+            ahead = (transId - window->nextTransId) & window->mask;
+            if (window->valid && ahead != 0 && ahead <= (window->mask >> 1))
+            {
+                window->nextTransId = transId;
+                window->gap = FALSE;
+            }
+        }
 
-        // Send the NAK message
-        SSPCOM_Send(self.sspDataForAckNak);
+        SSPOSAL_LockPut(self.hSspLock);
+
+        if (NULL == sspData)
+            break;
+
+        // Notify the client that message data received
+        NotifyListener(portId, sspData->packet.header.destId, sspData);
+        SSPCOM_ReleaseRecvData(sspData);
     }
-} 
+}
 
-/// Get the registered listener callback function
-/// @param[in] socketId A socket ID.
-/// @return The callback function for the socket ID.
-static SspDataCallback GetCallbackListener(UINT8 socketId)
+/// Check whether a received data message may be acknowledged. Fragments of 
+/// one message per socket are accepted in any order. A fragment of another 
+/// message is dropped without an ACK so the sender retransmits it after the 
+/// ACK timeout. 
+/// @param[in] sspData The received data message.
+/// @return TRUE if the message is not a fragment, is a duplicate, or is a 
+///     fragment of the message being reassembled.
+static BOOL AcceptFragment(const SspData* sspData)
 {
-    SspDataCallback callback;
+    Fragment fragment;
+#ifdef USE_SSP_FRAGMENTATION
+    const Reassembly* reassembly;
+    UINT16 transId;
+    BOOL duplicate;
+#endif
 
-    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+    ASSERT_TRUE(sspData != NULL);
 
-    // Get the registered callback listener for the socket
-    callback = self.socketToCallbackMap[socketId];
+    if (GetFragment(&sspData->packet, &fragment) == FALSE)
+        return TRUE;
 
+#ifdef USE_SSP_FRAGMENTATION
+    // Already received fragments are acknowledged again
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+    duplicate = IsDuplicate(sspData);
     SSPOSAL_LockPut(self.hSspLock);
-
-    return callback;
+    if (duplicate)
+        return TRUE;
+
+    // Invalid fragment?
+    if (fragment.size > SSP_MAX_MESSAGE_SIZE || GetFragmentSize(&fragment) == 0 ||
+        GetFragmentSize(&fragment) != 
+            sspData->packet.header.bodySize - GetExtSize(sspData->packet.header.type))
+        return FALSE;
+
+    reassembly = &self.reassembly[sspData->packet.header.destId];
+
+    // Fragments of a message have consecutive transaction IDs
+    transId = (GetTransId(&sspData->packet) - fragment.index) & 
+        GetTransIdMask(sspData->packet.header.type);
+
+    // Fragment of the message being reassembled?
+    if (reassembly->active && 
+        reassembly->srcId == sspData->packet.header.srcId &&
+        reassembly->transId == transId &&
+        reassembly->size == fragment.size &&
+        reassembly->count == fragment.count)
+        return TRUE;
+
+    // Start a new message unless a recent message is incomplete. The sender 
+    // retransmits the new message fragments once the message is complete.
+    return (!reassembly->active || 
+            SSPOSAL_GetTickCount() - reassembly->tickStamp > REASSEMBLY_TIMEOUT);
+#else
+    // Fragmented messages not supported
+    return FALSE;
+#endif
 }
 
-/// Callback the registered listener function pointer. 
-/// @param[in] socketId The socket identifier. 
-/// @param[in] sspData The data used in the notification. 
-static void CallbackListener(UINT8 socketId, const SspData* sspData)
+/// Add a received fragment to the socket message being reassembled. The 
+/// registered listener is called once the message is complete. 
+/// @param[in] socketId A socket identifier.
+/// @param[in] sspData The received fragment accepted by AcceptFragment().
+static void Reassemble(UINT8 socketId, const SspData* sspData)
 {
-    SspDataCallback callback;
+#ifdef USE_SSP_FRAGMENTATION
+    Reassembly* reassembly = &self.reassembly[socketId];
+    Fragment fragment;
+    UINT16 transId;
 
     ASSERT_TRUE(sspData != NULL);
 
-    callback = GetCallbackListener(socketId);
+    if (GetFragment(&sspData->packet, &fragment) == FALSE)
+        return;
 
-    // Is a callback registered?
-    if (NULL != callback)
+    transId = (GetTransId(&sspData->packet) - fragment.index) & 
+        GetTransIdMask(sspData->packet.header.type);
+
+    // Fragment of another message? Start a new message.
+    if (!reassembly->active || 
+        reassembly->srcId != sspData->packet.header.srcId ||
+        reassembly->transId != transId ||
+        reassembly->size != fragment.size ||
+        reassembly->count != fragment.count)
     {
-        // Callback client function with the received data
-        callback(
-                socketId,
-                sspData->packet.body,
-                sspData->packet.header.bodySize,
-                sspData->type,
-                sspData->err,
-                self.socketToUserDataMap[socketId]);
+        reassembly->active = TRUE;
+        reassembly->srcId = sspData->packet.header.srcId;
+        reassembly->transId = transId;
+        reassembly->size = fragment.size;
+        reassembly->count = fragment.count;
+        reassembly->remaining = fragment.count;
+        memset(reassembly->fragments, 0, sizeof(reassembly->fragments));
     }
-} 
+
+    // Copy fragment data into the message
+    if (!FRAG_BIT_GET(reassembly->fragments, fragment.index))
+    {
+        memcpy(&reassembly->data[GetFragmentOffset(&fragment)], 
+            sspData->packet.body + GetExtSize(sspData->packet.header.type), 
+            GetFragmentSize(&fragment));
+        FRAG_BIT_SET(reassembly->fragments, fragment.index);
+        reassembly->remaining--;
+    }
+    reassembly->tickStamp = SSPOSAL_GetTickCount();
+
+    // Message complete? Callback the registered socket listener.
+    if (reassembly->remaining == 0)
+    {
+        reassembly->active = FALSE;
+        CallbackListenerData(socketId, sspData, reassembly->data, reassembly->size);
+    }
+#else
+    (void)socketId;
+    (void)sspData;
+#endif
+}
 
 /// Notify the registered client of reception of data or errors. 
+/// @param[in] portId The port the data was sent or received on.
 /// @param[in] socketId A socket identifier.
 /// @param[in] sspData Data used in the notification. 
-static void NotifyListener(UINT8 socketId, const SspData* sspData)
+static void NotifyListener(SspPortId portId, UINT8 socketId, const SspData* sspData)
 {
-    SspPortId portId;
+    SspPortId srcPortId;
     SspErr err;
+    BOOL duplicate;
 
     ASSERT_TRUE(sspData != NULL);
 
     // Client only gets message data packets, not ACK/NAK packets
-    if (MSG_TYPE_DATA != sspData->packet.header.type)
+    if (MSG_TYPE_DATA != SSP_PACKET_TYPE(sspData->packet.header.type))
         return;
 
     // Was there a message error?
@@ -406,7 +1989,7 @@ static void NotifyListener(UINT8 socketId, const SspData* sspData)
     else
     {
         // Get the port ID that the incoming message arrived on
-        err = SSPCOM_GetPortId(sspData->packet.header.srcId, &portId);
+        err = SSPCOM_GetPortId(sspData->packet.header.srcId, &srcPortId);
         if (err == SSP_SUCCESS)
         {
             if (sspData->type == SSP_SEND)
@@ -419,25 +2002,30 @@ static void NotifyListener(UINT8 socketId, const SspData* sspData)
                 SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
 
                 // This message already received?
-                if (self.lastReceivedTransId[portId].transId == sspData->packet.header.transId &&
-                    self.lastReceivedTransId[portId].crc == *sspData->crc)
+                duplicate = IsDuplicate(sspData);
+                if (duplicate == FALSE)
                 {
-                    // Duplicate message. Message received already. Do not forward the
-                    // message to callback listeners.
-                    SSPOSAL_LockPut(self.hSspLock);
-                }
-                else
-                {
-                    // New message. Save the transId and crc  received to prevent
+                    // New message. Save the transId and crc received to prevent
                     // duplicate messages from being sent to the callback listeners
-                    self.lastReceivedTransId[portId].transId = sspData->packet.header.transId;
-                    self.lastReceivedTransId[portId].crc = *sspData->crc;
+                    RecordReceived(sspData);
+                }
 
-                    // Release lock before invoking callback below
-                    SSPOSAL_LockPut(self.hSspLock);
+                // Release lock before invoking callback below
+                SSPOSAL_LockPut(self.hSspLock);
 
-                    // Receive data succeeded. Callback the registered socket listener.
-                    CallbackListener(socketId, sspData);
+                if (duplicate == FALSE)
+                {
+                    // Message fragment? Callback once the message is complete.
+                    if (sspData->packet.header.type & SSP_FLAG_FRAG)
+                        Reassemble(socketId, sspData);
+                    else
+                    {
+                        // Receive data succeeded. Callback the registered socket 
+                        // listener. The listener may retain the receive data.
+                        self.recvCallbackData[portId] = sspData;
+                        CallbackListener(socketId, sspData);
+                        self.recvCallbackData[portId] = NULL;
+                    }
                 }
             }
         }
@@ -448,153 +2036,397 @@ static void NotifyListener(UINT8 socketId, const SspData* sspData)
     }
 } 
 
-/// Process outgoing socket data to send. 
+/// Get the oldest unacknowledged transaction ID of an outgoing message.
+/// @param[in] sendData A message within the list.
+/// @return The message transaction ID or the oldest unacknowledged fragment 
+///     transaction ID of a fragmented message.
+static UINT16 GetOldestTransId(const SendData* sendData)
+{
+#ifdef USE_SSP_FRAGMENTATION
+    if (NULL != sendData->frag)
+        return (sendData->msgTransId + sendData->frag->base) & 
+            GetTransIdMask(sendData->sspData->packet.header.type);
+#endif
+    return sendData->msgTransId;
+}
+
+/// Check whether a message transaction ID is within the send window of the oldest
+/// unacknowledged message to the same socket pair. Limiting the transaction ID 
+/// span keeps retransmissions within the receiver replay window.
+/// @param[in] portId A port identifier. 
+/// @param[in] sendData A message within the list.
+/// @param[in] transId The transaction ID of the message or fragment to send.
+/// @return TRUE if the message may be sent.
+static BOOL InSendWindow(SspPortId portId, const SendData* sendData, UINT16 transId)
+{
+    const SspPacketHeader* header = &sendData->sspData->packet.header;
+    const SendDataPair* pair = &self.sendDataPair[header->srcId][header->destId];
+    BOOL inWindow;
+    UINT16 span;
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Get the span from the oldest message to the same socket pair
+    ASSERT_TRUE(pair->head != NULL);
+    span = (transId - GetOldestTransId(pair->head)) & GetTransIdMask(header->type);
+    inWindow = span < self.sendWindow[portId];
+
+    // A fragmented message waits for older fragmented messages to the same 
+    // socket pair. ProcessSend() skips the waiting message, so other messages 
+    // queued behind it, including messages to the same socket pair, are sent 
+    // within the send window while a fragmented message is in flight.
+    if ((header->type & SSP_FLAG_FRAG) && pair->frag != sendData)
+        inWindow = FALSE;
+
+    SSPOSAL_LockPut(self.hSspLock);
+
+    return inWindow;
+}
+
+/// Send an outgoing message. A fragmented message resends each fragment in 
+/// flight not yet acknowledged. 
+/// @param[in] sendData A message within the list.
+/// @return SSP_SUCCESS if success.
+static SspErr SendMessage(SendData* sendData)
+{
+#ifdef USE_SSP_FRAGMENTATION
+    FragSend* frag = sendData->frag;
+    SspErr err = SSP_SUCCESS;
+    UINT8 index;
+
+    if (NULL != frag)
+    {
+        for (index = frag->base; index < frag->next && err == SSP_SUCCESS; index++)
+        {
+            if (!FRAG_BIT_GET(frag->acked, index))
+                err = SendFragment(sendData, index);
+        }
+
+        // The ACK of a retransmitted fragment is ambiguous
+        frag->rttSample = FALSE;
+        return err;
+    }
+#endif
+    return SSPCOM_Send(sendData->sspData);
+}
+
+#ifdef USE_SSP_FRAGMENTATION
+/// Send one fragment of a fragmented message. The fragment packet is built 
+/// within the message SspData.
+/// @param[in] sendData A fragmented message within the list.
+/// @param[in] index The fragment index.
+/// @return SSP_SUCCESS if success.
+static SspErr SendFragment(SendData* sendData, UINT8 index)
+{
+    SspPacket* packet = &sendData->sspData->packet;
+    Fragment fragment;
+    UINT16 size;
+    UINT8 extSize;
+
+    fragment.size = sendData->frag->size;
+    fragment.count = sendData->frag->count;
+    fragment.index = index;
+    size = GetFragmentSize(&fragment);
+    extSize = GetExtSize(packet->header.type);
+
+    SSPCOM_InitSspData(sendData->sspData, extSize + size);
+    packet->header.bodySize = (UINT8)(extSize + size);
+    SetTransId(packet, sendData->msgTransId + index);
+    SetFragment(packet, &fragment);
+    memcpy(packet->body + extSize, sendData->frag->data + GetFragmentOffset(&fragment), size);
+
+    return SSPCOM_Send(sendData->sspData);
+}
+
+/// Send the fragments of a message not yet sent within the send window. 
+/// @param[in] portId A port identifier. 
+/// @param[in] sendData A fragmented message within the list.
+/// @param[in,out] windowCnt The number of messages in flight on the port. 
+///     Incremented by the number of message fragments in flight.
+/// @return SSP_SUCCESS if success.
+static SspErr SendNextFragments(SspPortId portId, SendData* sendData, UINT16* windowCnt)
+{
+    FragSend* frag = sendData->frag;
+    SspErr err = SSP_SUCCESS;
+
+    while (frag->next < frag->count &&
+           *windowCnt + (frag->next - frag->base) < self.sendWindow[portId] &&
+           InSendWindow(portId, sendData, (UINT16)(sendData->msgTransId + frag->next)))
+    {
+        err = SendFragment(sendData, frag->next);
+        if (err != SSP_SUCCESS)
+            break;
+
+        // The ACK timeout restarts on each fragment sent. The ACK of a fragment 
+        // sent once measures the round trip time.
+        frag->next++;
+        frag->rttSample = TRUE;
+        sendData->sendTickStamp = SSPOSAL_GetTickCount();
+    }
+
+    *windowCnt += frag->next - frag->base;
+    return err;
+}
+#endif
+
+/// Process outgoing socket data to send. Up to the port send window number of 
+/// messages at the list front are in flight at once, each fragment of a 
+/// fragmented message counting as one message. Messages are serviced in list 
+/// order so a retransmission always precedes newer messages. A message outside
+/// the send window of its socket pair is skipped so other socket pairs on the 
+/// port are not blocked.
 /// @param[in] portId A port identifier. 
 static void ProcessSend(SspPortId portId)
 {
     SendData* sendData;
+    SendData* nextData;
+    UINT16 windowCnt = 0;
     SspErr err;
 
-    // Get next message to transmit from list front
+    // Get first message within the send window from list front
     sendData = ListFront(portId);
 
-    // If there is data and message is ready to send
-    if (NULL != sendData && SEND_STATE == sendData->state)
+    // Iterate over each message within the send window
+    while (NULL != sendData && windowCnt < self.sendWindow[portId])
     {
-        // Is retry count low enough to send?
-        if (sendData->sendRetries++ <= SSP_MAX_RETRIES)
+        // Get the next message now since sendData may be removed below
+        nextData = ListNext(sendData);
+
+        // Transaction ID too far ahead of an unacknowledged message to the 
+        // same socket pair? Try the next message.
+        if (InSendWindow(portId, sendData, GetOldestTransId(sendData)) == FALSE)
+        {
+            sendData = nextData;
+            continue;
+        }
+
+        // Is message ready to send?
+        if (SEND_STATE == sendData->state)
         {
-            // Send the packet
-            err = SSPCOM_Send(sendData->sspData);
-            if (err == SSP_SUCCESS)
+            // Is retry count low enough to send?
+            if (sendData->sendRetries++ <= SSP_MAX_RETRIES)
             {
-                // Update the time sent
-                sendData->sendTickStamp = SSPOSAL_GetTickCount();
+                // Send the packet
+                err = SendMessage(sendData);
+                if (err == SSP_SUCCESS)
+                {
+                    // Update the time sent
+                    sendData->sendTickStamp = SSPOSAL_GetTickCount();
+
+                    // Waiting for the ACK
+                    sendData->state = RECEIVE_STATE;
+                }
+                else
+                {
+                    SSP_TRACE_FORMAT("Send failed. Port: %d Socket: %d Trans: %d",
+                        portId, 
+                        sendData->sspData->packet.header.srcId, 
+                        sendData->sspData->packet.header.transId);
 
-                // Waiting for the ACK
-                sendData->state = RECEIVE_STATE;
+                    // Stop sending to keep messages in order. Try again next time.
+                    break;
+                }
             }
             else
             {
-                SSP_TRACE_FORMAT("Send failed. Port: %d Socket: %d Trans: %d",
-                    portId, 
-                    sendData->sspData->packet.header.srcId, 
-                    sendData->sspData->packet.header.transId);
+                // Notify client that the retries exceeded
+                NotifySend(portId, sendData, SSP_SEND_RETRIES_FAILED);
+
+                // Remove message from the list. Max retries were exceeded.
+                ListErase(portId, sendData);
+                FreeSendData(sendData);
+
+                // Next message moves into the send window
+                sendData = nextData;
+                continue;
             }
         }
-        else
+
+#ifdef USE_SSP_FRAGMENTATION
+        if (NULL != sendData->frag)
         {
-            // Notify client that the retries exceeded
-            sendData->sspData->err = SSP_SEND_RETRIES_FAILED;
-            NotifyListener(sendData->sspData->packet.header.srcId, sendData->sspData);
+            // Send the next fragments of the message
+            if (SendNextFragments(portId, sendData, &windowCnt) != SSP_SUCCESS)
+                break;
 
-            // Remove message from the list. Max retries were exceeded.
-            ListErase(portId, sendData);
-            FreeSendData(sendData);
+            sendData = nextData;
+            continue;
         }
+#endif
+
+        windowCnt++;
+        sendData = nextData;
     }
 } 
 
-/// Process incoming socket data. Registered listener is notified. Handle 
-/// message timeouts and ACK/NAK.
+/// Receive a single packet. Registered listener is notified and ACK/NAK 
+/// messages handled.
 /// @param[in] portId A port identifier. 
-static void ProcessReceive(SspPortId portId)
+static void ReceivePacket(SspPortId portId)
 {
     const SspData* sspData = NULL;
     SendData* sendData = NULL;
+    SspPacketHeader header;
     SspErr err;
-    UINT16 packetCnt = 0;
+    UINT8 type;
+
+    // Try to receive a single SSP packet
+    err = SSPCOM_ProcessReceive(portId, &sspData, SSP_RECV_TIMEOUT);
 
-    // Is there data in the receive buffer?
-    if (SSPHAL_IsRecvQueueEmpty(portId) == FALSE)
+    // Receive succeeded?
+    if (err == SSP_SUCCESS && sspData)
     {
-        // Try to receive a single SSP packet
-        err = SSPCOM_ProcessReceive(portId, &sspData, SSP_RECV_TIMEOUT);
+        // Received message. Decode the message and handle.
+        type = SSP_PACKET_TYPE(sspData->packet.header.type);
 
-        // Receive succeeded?
-        if (err == SSP_SUCCESS && sspData)
+        // Body too small to hold the extension fields? Ignore message.
+        if (sspData->packet.header.bodySize < GetExtSize(sspData->packet.header.type))
         {
-            // Received message. Decode the message and handle.
+            SSP_TRACE("Bad extension fields received.");
+        }
 
-            // Did ACK message arrive?
-            if (sspData->packet.header.type == MSG_TYPE_ACK)
-            {
-                // Success! Client's message successfully transmitted over SSP.
-                SSP_TRACE_FORMAT("ACK received. Port: %d Socket: %d Trans: %d", 
-                    portId, sspData->packet.header.srcId, sspData->packet.header.transId);
+        // Did ACK message arrive?
+        else if (type == MSG_TYPE_ACK)
+        {
+            // Success! Client's message successfully transmitted over SSP.
+            SSP_TRACE_FORMAT("ACK received. Port: %d Socket: %d Trans: %d", 
+                portId, sspData->packet.header.srcId, GetTransId(&sspData->packet));
 
-                // Find the SendData instance associated with this ACK
-                sendData = ListFind(portId, &sspData->packet.header);
+            // Find the SendData instance associated with this ACK
+            sendData = ListFind(portId, &sspData->packet.header, GetTransId(&sspData->packet));
 
-                // Free the SendData as the transmission was successful
-                if (NULL != sendData)
-                {
-                    // Let client know remote CPU accepted the message
-                    sendData->sspData->err = SSP_SUCCESS;
-                    NotifyListener(sendData->sspData->packet.header.srcId, sendData->sspData);
+            // Free the SendData as the transmission was successful
+            if (NULL != sendData)
+                AckSendData(portId, sendData, GetTransId(&sspData->packet));
+        }
 
-                    // Free allocated memory
-                    ListErase(portId, sendData);
-                    FreeSendData(sendData);
-                }
-            }
+        // Did SACK message arrive?
+        else if (type == MSG_TYPE_SACK)
+        {
+            SSP_TRACE_FORMAT("SACK received. Port: %d Socket: %d Trans: %d", 
+                portId, sspData->packet.header.srcId, GetTransId(&sspData->packet));
 
-            // Did NAK message arrive?
-            else if (sspData->packet.header.type == MSG_TYPE_NAK)
-            {
-                SSP_TRACE_FORMAT("NAK received. Port: %d Socket: %d", portId, sspData->packet.header.destId);
+            // Free every SendData instance acknowledged by this SACK
+            ProcessSack(portId, sspData);
+        }
 
-                // Find the SendData associated with this NAK
-                sendData = ListFind(portId, &sspData->packet.header);
+        // Did NAK message arrive?
+        else if (type == MSG_TYPE_NAK)
+        {
+            SSP_TRACE_FORMAT("NAK received. Port: %d Socket: %d", portId, sspData->packet.header.destId);
 
-                // Set message state to SEND_STATE to force a retransmission
-                if (NULL != sendData)
-                    sendData->state = SEND_STATE;
-            }
+            // Find the SendData associated with this NAK
+            sendData = ListFind(portId, &sspData->packet.header, GetTransId(&sspData->packet));
+
+            // Set message state to SEND_STATE to force a retransmission
+            if (NULL != sendData)
+                sendData->state = SEND_STATE;
+        }
+
+        // Did data message arrive?
+        else if (type == MSG_TYPE_DATA)
+        {
+            SSP_TRACE_FORMAT("Data received. Port: %d Socket: %d Trans: %d", portId, 
+                sspData->packet.header.destId, GetTransId(&sspData->packet));
 
-            // Did data message arrive?
-            else if (sspData->packet.header.type == MSG_TYPE_DATA)
+            // Is a listener registered on the destination socket?
+            if (GetCallbackListener(sspData->packet.header.destId))
             {
-                SSP_TRACE_FORMAT("Data received. Port: %d Socket: %d Trans: %d", portId, 
-                    sspData->packet.header.destId, sspData->packet.header.transId);
+                // Message ahead of a missing message and held?
+                if (AcceptInOrder(portId, sspData) == FALSE && HoldReceived(portId, sspData))
+                {
+                    // ACK the received message. Delivered once older messages arrive.
+                    QueueAck(portId, &sspData->packet.header, GetTransId(&sspData->packet));
+                }
 
-                // Is a listener registered on the destination socket?
-                if (GetCallbackListener(sspData->packet.header.destId))
+                // Not a fragment of another message? A message that cannot be 
+                // held is delivered out of order.
+                else if (AcceptFragment(sspData))
                 {
                     // ACK the received message
-                    SendAck(&sspData->packet.header);
+                    QueueAck(portId, &sspData->packet.header, GetTransId(&sspData->packet));
+
+                    // Deliver held messages older than this message
+                    DeliverHeld(portId);
 
                     // Notify the client that message data received
-                    NotifyListener(sspData->packet.header.destId, sspData);
+                    NotifyListener(portId, sspData->packet.header.destId, sspData);
+
+                    // Deliver held messages following this message
+                    DeliverHeld(portId);
                 }
                 else
                 {
-                    // NAK received message. No client to handle message.
-                    SendNak(&sspData->packet.header);
+                    // Fragment of another message. Drop it and wait for the retransmission.
+                    SSP_TRACE("Fragment dropped.");
                 }
             }
-
             else
             {
-                // Unknown message type received. Should never happen.
-                SSP_TRACE("Unknown packet received.");
+                // NAK received message. No client to handle message.
+                SendNak(portId, &sspData->packet.header, GetTransId(&sspData->packet));
             }
         }
-        else if (sspData)
-        {
-            // For a corrupted message data with header intact, send a NAK to force 
-            // sender to retransmit
-            if ((SSP_CORRUPTED_PACKET == err || SSP_PARTIAL_PACKET_HEADER_VALID == err) &&
-                 MSG_TYPE_DATA == sspData->packet.header.type)
-            {
-                // Data message received but it was corrupted, send NAK and try again
-                SendNak(&sspData->packet.header);
-            }
 
-            SSP_TRACE_FORMAT("*** Corrupt data received. Port %d Err %d ***", portId, err);
+        else
+        {
+            // Unknown message type received. Should never happen.
+            SSP_TRACE("Unknown packet received.");
+        }
+    }
+    else if (sspData)
+    {
+        // For a corrupted message data with header intact, send a NAK to force 
+        // sender to retransmit
+        if ((SSP_CORRUPTED_PACKET == err || SSP_PARTIAL_PACKET_HEADER_VALID == err) &&
+             MSG_TYPE_DATA == SSP_PACKET_TYPE(sspData->packet.header.type))
+        {
+            // Data message received but it was corrupted, send NAK and try again.
+            // The body is not trusted so only the transaction ID low byte is known.
+            header = sspData->packet.header;
+            header.type &= ~SSP_FLAG_EXT_SEQ;
+            SendNak(portId, &header, header.transId);
+        }
+        else if ((SSP_SOCKET_NOT_OPEN == err || SSP_BAD_SOCKET_ID == err) &&
+             MSG_TYPE_DATA == SSP_PACKET_TYPE(sspData->packet.header.type))
+        {
+            // Valid data message to a closed socket was dropped, send NAK. The body 
+            // was not received so only the transaction ID low byte is known.
+            header = sspData->packet.header;
+            header.type &= ~SSP_FLAG_EXT_SEQ;
+            SendNak(portId, &header, header.transId);
         }
+
+        SSP_TRACE_FORMAT("*** Corrupt data received. Port %d Err %d ***", portId, err);
+    }
+}
+
+/// Process incoming socket data. Registered listener is notified. Handle 
+/// message timeouts and ACK/NAK.
+/// @param[in] portId A port identifier. 
+/// @param[in] packetBudget The maximum number of packets to receive. 0 is no limit.
+/// @param[in] timeBudget The maximum time to spend receiving in mS. 0 is no limit.
+static void ProcessReceive(SspPortId portId, UINT16 packetBudget, UINT32 timeBudget)
+{
+    SendData* sendData = NULL;
+    UINT16 packetCnt = 0;
+    UINT16 recvCnt = 0;
+    UINT32 startTime = SSPOSAL_GetTickCount();
+
+    // Receive all packets in the receive buffer or until a budget is spent
+    while (SSPCOM_IsRecvQueueEmpty(portId) == FALSE)
+    {
+        ReceivePacket(portId);
+
+        if (packetBudget != 0 && ++recvCnt >= packetBudget)
+            break;
+        if (timeBudget != 0 && SSPOSAL_GetTickCount() - startTime >= timeBudget)
+            break;
     }
 
+    // Acknowledge received messages
+    FlushAck(portId, FALSE);
+
     // Get the list head
     sendData = ListFront(portId);
 
@@ -605,7 +2437,7 @@ static void ProcessReceive(SspPortId portId)
     {
         // Packet receive ACK timeout expired?
         if (sendData->state == RECEIVE_STATE &&
-            SSPOSAL_GetTickCount() - sendData->sendTickStamp > SSP_ACK_TIMEOUT)
+            SSPOSAL_GetTickCount() - sendData->sendTickStamp > GetAckTimeout(portId, sendData))
         {
             // Try sending the message again
             sendData->state = SEND_STATE;
@@ -628,26 +2460,65 @@ static void ProcessReceive(SspPortId portId)
 SspErr SSP_Init(SspPortId portId)
 {
     SspErr err;
+    UINT16 port;
 
     if (self.initOnce == FALSE)
     {
         self.initOnce = TRUE;
 
+        // Set the default send window and ACK timeout on all ports
+        for (port = SSP_PORT1; port < SSP_MAX_PORTS; port++)
+        {
+            self.sendWindow[port] = SSP_SEND_WINDOW;
+            self.rtt[port].ackTimeout = SSP_ACK_TIMEOUT;
+        }
+
         // Initialize allocator module
 #ifdef USE_FB_ALLOCATOR
         ALLOC_Init();
 #endif
         self.hSspLock = SSPOSAL_LockCreate();
-
-        // Create SspData object for ACK/NAK usage
-        self.sspDataForAckNak = (SspData*)self.sspDataForAckNakMem;
-        SSPCOM_InitSspData(self.sspDataForAckNak, 0);
     }
     
     err = SSPCOM_Init(portId);
     return err;
 }
 
+/// Process incoming and outgoing data on an open port.
+/// @param[in] portId A port identifier.
+/// @param[in] packetBudget The maximum number of packets to receive. 
+/// @param[in] timeBudget The maximum time to spend receiving in mS. 
+static void ProcessPort(SspPortId portId, UINT16 packetBudget, UINT32 timeBudget)
+{
+    // Is the port open?
+    if (SSPCOM_IsPortOpen(portId) == TRUE)
+    {
+        // Process incoming data on the specified port
+        ProcessReceive(portId, packetBudget, timeBudget);
+
+        // Deliver held messages whose missing message is overdue
+        DeliverHeld(portId);
+
+        // Process outgoing data on the specified port
+        ProcessSend(portId);
+    }
+}
+
+/// Get the outgoing message state of all open ports. 
+/// @return TRUE if no open port has outgoing messages to process.
+static BOOL IsSendIdle(void)
+{
+    UINT16 portId;
+
+    for (portId=SSP_PORT1; portId<SSP_MAX_PORTS; portId++)
+    {
+        // Messages still in outgoing list?
+        if (SSPCOM_IsPortOpen((SspPortId)portId) == TRUE && ListSize((SspPortId)portId) > 0)
+            return FALSE;
+    }
+    return TRUE;
+}
+
 /// Terminate SSP and cleanup resources. 
 void SSP_Term(void)
 {
@@ -665,6 +2536,20 @@ void SSP_Term(void)
         }
     }
 
+    // Release messages reserved but never committed
+    for (portId=SSP_PORT1; portId<SSP_MAX_PORTS; portId++)
+    {
+        while ((sendData = self.reservedList[portId]) != NULL)
+        {
+            self.reservedList[portId] = sendData->next;
+            FreeSendData(sendData);
+        }
+        self.claimedCnt[portId] = 0;
+    }
+
+    // Held receive buffers are freed by SSPCOM_Term()
+    self.recvHoldCnt = 0;
+
     SSPOSAL_LockDestroy(self.hSspLock);
     self.hSspLock = SSP_OSAL_INVALID_HANDLE_VALUE;
     SSPCOM_Term();
@@ -692,7 +2577,42 @@ SspErr SSP_CloseSocket(UINT8 socketId)
     return SSPCOM_CloseSocket(socketId);
 } 
 
-/// Asynchronously send multiple data buffers over a socket. 
+/// Copy a range of bytes from an array of data buffers treated as one buffer.
+/// @param[out] dest The destination buffer.
+/// @param[in] offset The offset of the first byte to copy.
+/// @param[in] size The number of bytes to copy.
+/// @param[in] numData The number of array elements.
+/// @param[in] dataArray An array of data with numData elements. 
+/// @param[in] dataSizeArray An array of dataArray sizes with numData elements.
+static void CopyData(UINT8* dest, UINT16 offset, UINT16 size, INT16 numData, 
+    void const** dataArray, const UINT16* dataSizeArray)
+{
+    INT16 i;
+    UINT16 len;
+
+    for (i = 0; i < numData && size > 0; ++i)
+    {
+        // Range starts after this buffer?
+        if (offset >= dataSizeArray[i])
+        {
+            offset -= dataSizeArray[i];
+            continue;
+        }
+
+        // Copy data into destination buffer
+        len = dataSizeArray[i] - offset;
+        if (len > size)
+            len = size;
+        memcpy(dest, (const UINT8*)dataArray[i] + offset, len);
+
+        dest += len;
+        size -= len;
+        offset = 0;
+    }
+}
+
+/// Asynchronously send multiple data buffers over a socket. Data larger than 
+/// one packet is sent as multiple fragments if USE_SSP_FRAGMENTATION is defined.
 /// @param[in] srcSocketId A source socket identifier.
 /// @param[in] destSocketId A destination socket identifier.
 /// @param[in] numData The number of array elements.
@@ -703,13 +2623,14 @@ SspErr SSP_SendMultiple(UINT8 srcSocketId, UINT8 destSocketId, INT16 numData,
     void const** dataArray, UINT16* dataSizeArray)
 {
     INT16 i;
-    UINT8* dest;
     SspPortId portId;
-    SendData* sendData = NULL;
+    SendData* sendData;
     SspErr err = SSP_SUCCESS;
-    UINT16 bytesCopied = 0;
-    UINT16 bufSize = 0;
     UINT16 dataSize = 0;
+    UINT16 maxSize;
+    Fragment fragment;
+    UINT8 flags = DATA_EXT_FLAGS;
+    UINT8 extSize;
 
     if (NULL == dataArray || NULL == *dataArray || NULL == dataSizeArray)
         return SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
@@ -718,9 +2639,32 @@ SspErr SSP_SendMultiple(UINT8 srcSocketId, UINT8 destSocketId, INT16 numData,
     for (i=0; i<numData; ++i)
         dataSize += dataSizeArray[i];
 
-    // Data size too large?
-    if (dataSize > SSP_MAX_BODY_SIZE)
+    fragment.size = dataSize;
+    fragment.index = 0;
+    fragment.count = 1;
+
+    // Data size too large for one packet?
+    maxSize = SSP_MAX_BODY_SIZE - GetExtSize(flags);
+    if (dataSize > maxSize)
+    {
+#ifdef USE_SSP_FRAGMENTATION
+        // Split the data into the fewest fragments
+        flags |= SSP_FLAG_FRAG;
+        maxSize = SSP_MAX_BODY_SIZE - GetExtSize(flags);
+
+        if (dataSize > SSP_MAX_MESSAGE_SIZE || 
+            (dataSize + maxSize - 1) / maxSize > MAX_FRAGMENTS)
+            return SSPCMN_ReportErr(SSP_DATA_SIZE_TOO_LARGE);
+
+        fragment.count = (UINT8)((dataSize + maxSize - 1) / maxSize);
+#else
         return SSPCMN_ReportErr(SSP_DATA_SIZE_TOO_LARGE);
+#endif
+    }
+    extSize = GetExtSize(flags);
+
+    if (destSocketId >= SSP_SOCKET_MAX)
+        return SSPCMN_ReportErr(SSP_BAD_SOCKET_ID);
 
     // Get port ID for socket
     err = SSPCOM_GetPortId(srcSocketId, &portId);
@@ -728,77 +2672,254 @@ SspErr SSP_SendMultiple(UINT8 srcSocketId, UINT8 destSocketId, INT16 numData,
         return SSPCMN_ReportErr(SSP_BAD_SOCKET_ID);
 
     // Too many messages waiting?
-    if (ListSize(portId) >= SSP_MAX_MESSAGES)
+    if (!ClaimQueue(portId))
         return SSPCMN_ReportErr(SSP_QUEUE_FULL);
 
-    // Create outgoing send message structure
-    sendData = AllocSendData(dataSize);
+    // Create outgoing send message structure. A fragmented message is one 
+    // structure holding the whole message.
+#ifdef USE_SSP_FRAGMENTATION
+    sendData = (flags & SSP_FLAG_FRAG) ? 
+        AllocFragSendData(dataSize) : AllocSendData(extSize + dataSize);
+#else
+    sendData = AllocSendData(extSize + dataSize);
+#endif
     if (!sendData)
+    {
+        ReleaseQueue(portId);
         return SSPCMN_ReportErr(SSP_OUT_OF_MEMORY);
+    }
+
+    // Fill in packet header information
+    sendData->sspData->type = SSP_SEND;
+    sendData->sspData->packet.header.srcId = srcSocketId;
+    sendData->sspData->packet.header.destId = destSocketId;
+    sendData->sspData->packet.header.type = MSG_TYPE_DATA | flags;
 
-    // Is there client data?
-    if (dataSize > 0)
+    if (flags & SSP_FLAG_FRAG)
+    {
+        // Set the fragment count used to reserve the transaction IDs and copy 
+        // client data into the message. Each fragment packet is built when sent.
+        SetFragment(&sendData->sspData->packet, &fragment);
+#ifdef USE_SSP_FRAGMENTATION
+        sendData->frag->count = fragment.count;
+        CopyData(sendData->frag->data, 0, dataSize, numData, dataArray, dataSizeArray);
+#endif
+    }
+    else
     {
         // Copy client data into packet body
-        dest = sendData->sspData->packet.body;
-        for ( i = 0; i < numData; ++i )
-        {
-            // Compute how much destination buffer remains
-            bufSize = dataSize - bytesCopied;
+        sendData->sspData->packet.header.bodySize = (UINT8)(extSize + dataSize);
+        CopyData(sendData->sspData->packet.body + extSize, 0, dataSize, 
+            numData, dataArray, dataSizeArray);
+    }
 
-            // Ensure computed value is within dataSize range
-            if (bufSize <= dataSize)
-            {
-                // Copy data into destination packet body buffer
-                memcpy(dest, dataArray[i], dataSizeArray[i]);
+    // Insert the outgoing message into the list
+    ListInsert(portId, sendData);
 
-                dest += dataSizeArray[i];
-                bytesCopied += dataSizeArray[i];
-            }
-            else
+    // Disable power savings for outgoing message
+    SSPHAL_PowerSave(FALSE);
+
+    return SSP_SUCCESS;
+} 
+
+/// Asynchronously send data over a socket. The registered callback on SSP_Listener()
+/// will be invoked upon success or failure of the sent message. 
+/// @param[in] srcSocketId A source socket identifier.
+/// @param[in] destSocketId A destination socket identifier.
+/// @param[in] data The data to send. 
+/// @param[in] dataSize The size of data in bytes.
+/// @return SSP_SUCCESS if success.
+SspErr SSP_Send(UINT8 srcSocketId, UINT8 destSocketId, const void* data, UINT16 dataSize)
+{
+    return SSP_SendMultiple(srcSocketId, destSocketId, 1, &data, &dataSize);
+}
+
+/// Find a reserved message. Caller must hold the lock.
+/// @param[in] data The packet body location returned by SSP_ReserveSend().
+/// @param[out] portId The port the message queue entry is claimed on.
+/// @param[out] link The pointer to the message within the reserved list.
+/// @return The reserved message or NULL if not found.
+static SendData* FindReserved(const void* data, SspPortId* portId, SendData*** link)
+{
+    SendData* sendData = NULL;
+    const SspPacket* packet;
+    INT16 port;
+
+    for (port = SSP_PORT1; port < SSP_MAX_PORTS && NULL == sendData; port++)
+    {
+        for (*link = &self.reservedList[port]; NULL != (sendData = **link); *link = &sendData->next)
+        {
+            packet = &sendData->sspData->packet;
+            if (packet->body + GetExtSize(packet->header.type) == data)
             {
-                err = SSPCMN_ReportErr(SSP_SOFTWARE_FAULT);
-                ASSERT();
+                *portId = (SspPortId)port;
                 break;
             }
         }
     }
 
-    if (err == SSP_SUCCESS)
+    return sendData;
+}
+
+/// Reserve an outgoing message so the client writes data directly into the 
+/// packet body without an intermediate copy. Call SSP_CommitSend() to send the 
+/// message or SSP_CancelSend() to release it. 
+/// @param[in] srcSocketId A source socket identifier.
+/// @param[in] destSocketId A destination socket identifier.
+/// @param[in] dataSize The maximum data size in bytes. Must fit within one packet.
+/// @param[out] data The packet body location to write the data. 
+/// @return SSP_SUCCESS if success.
+SspErr SSP_ReserveSend(UINT8 srcSocketId, UINT8 destSocketId, UINT16 dataSize, void** data)
+{
+    SspPortId portId;
+    SendData* sendData;
+    SspErr err;
+    UINT8 extSize = GetExtSize(DATA_EXT_FLAGS);
+
+    if (NULL == data)
+        return SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
+    *data = NULL;
+
+    // Data size too large?
+    if (dataSize > SSP_MAX_BODY_SIZE - extSize)
+        return SSPCMN_ReportErr(SSP_DATA_SIZE_TOO_LARGE);
+
+    if (destSocketId >= SSP_SOCKET_MAX)
+        return SSPCMN_ReportErr(SSP_BAD_SOCKET_ID);
+
+    // Get port ID for socket
+    err = SSPCOM_GetPortId(srcSocketId, &portId);
+    if (err != SSP_SUCCESS)
+        return SSPCMN_ReportErr(SSP_BAD_SOCKET_ID);
+
+    // Too many messages waiting? The queue entry is held until committed.
+    if (!ClaimQueue(portId))
+        return SSPCMN_ReportErr(SSP_QUEUE_FULL);
+
+    // Create outgoing send message structure
+    sendData = AllocSendData(extSize + dataSize);
+    if (!sendData)
     {
-        // Fill in packet header information
-        sendData->sspData->type = SSP_SEND;
-        sendData->sspData->packet.header.bodySize = (UINT8)dataSize;
-        sendData->sspData->packet.header.srcId = srcSocketId;
-        sendData->sspData->packet.header.destId = destSocketId;
-        sendData->sspData->packet.header.transId = self.sendTransId++;
-        sendData->sspData->packet.header.type = MSG_TYPE_DATA;
+        ReleaseQueue(portId);
+        return SSPCMN_ReportErr(SSP_OUT_OF_MEMORY);
+    }
+
+    // Fill in packet header information
+    sendData->sspData->type = SSP_SEND;
+    sendData->sspData->packet.header.bodySize = (UINT8)(extSize + dataSize);
+    sendData->sspData->packet.header.srcId = srcSocketId;
+    sendData->sspData->packet.header.destId = destSocketId;
+    sendData->sspData->packet.header.type = MSG_TYPE_DATA | DATA_EXT_FLAGS;
+
+    // Hold the message until committed
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+    sendData->next = self.reservedList[portId];
+    self.reservedList[portId] = sendData;
+    SSPOSAL_LockPut(self.hSspLock);
+
+    *data = sendData->sspData->packet.body + extSize;
+    return SSP_SUCCESS;
+}
+
+/// Send a message reserved using SSP_ReserveSend(). The registered callback on 
+/// SSP_Listen() will be invoked upon success or failure of the sent message. 
+/// @param[in] data The packet body location returned by SSP_ReserveSend().
+/// @param[in] dataSize The number of bytes written. Must not exceed the 
+///     reserved data size.
+/// @return SSP_SUCCESS if success. The reservation is released even if the 
+///     socket is no longer open. 
+SspErr SSP_CommitSend(void* data, UINT16 dataSize)
+{
+    SspPortId reservedPortId = SSP_INVALID_PORT;
+    SspPortId portId;
+    SendData* sendData;
+    SendData** link;
+    SspPacket* packet;
+    SspErr err = SSP_SUCCESS;
+    UINT8 extSize;
+
+    if (NULL == data)
+        return SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
 
-        // Insert the outgoing message into the list
-        ListInsert(portId, sendData);
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
 
-        // Disable power savings for outgoing message
-        SSPHAL_PowerSave(FALSE);
+    // Find the reserved message and check the size fits
+    sendData = FindReserved(data, &reservedPortId, &link);
+    if (NULL == sendData)
+    {
+        err = SSP_BAD_ARGUMENT;
     }
-    else 
+    else
     {
-        // Free allocated memory if not successful  
-        FreeSendData(sendData);       
+        packet = &sendData->sspData->packet;
+        extSize = GetExtSize(packet->header.type);
+        if (dataSize > packet->header.bodySize - extSize)
+        {
+            err = SSP_DATA_SIZE_TOO_LARGE;
+        }
+        else
+        {
+            // Remove from the reserved list and set the packet size
+            *link = sendData->next;
+            SSPCOM_InitSspData(sendData->sspData, extSize + dataSize);
+            packet->header.bodySize = (UINT8)(extSize + dataSize);
+        }
     }
 
-    return err;
-} 
+    SSPOSAL_LockPut(self.hSspLock);
 
-/// Asynchronously send data over a socket. The registered callback on SSP_Listener()
-/// will be invoked upon success or failure of the sent message. 
-/// @param[in] srcSocketId A source socket identifier.
-/// @param[in] destSocketId A destination socket identifier.
-/// @param[in] data The data to send. 
-/// @param[in] dataSize The size of data in bytes.
-/// @return SSP_SUCCESS if success.
-SspErr SSP_Send(UINT8 srcSocketId, UINT8 destSocketId, const void* data, UINT16 dataSize)
+    if (err != SSP_SUCCESS)
+        return SSPCMN_ReportErr(err);
+
+    // Get port ID for socket. The socket must still be open on the port 
+    // holding the claimed queue entry.
+    err = SSPCOM_GetPortId(packet->header.srcId, &portId);
+    if (err != SSP_SUCCESS || portId != reservedPortId)
+    {
+        ReleaseQueue(reservedPortId);
+        FreeSendData(sendData);
+        return SSPCMN_ReportErr(SSP_BAD_SOCKET_ID);
+    }
+
+    // Insert the outgoing message into the list using the claimed entry
+    ListInsert(portId, sendData);
+
+    // Disable power savings for outgoing message
+    SSPHAL_PowerSave(FALSE);
+
+    return SSP_SUCCESS;
+}
+
+/// Release a message reserved using SSP_ReserveSend() without sending it.
+/// @param[in] data The packet body location returned by SSP_ReserveSend().
+/// @return SSP_SUCCESS if success. 
+SspErr SSP_CancelSend(void* data)
 {
-    return SSP_SendMultiple(srcSocketId, destSocketId, 1, &data, &dataSize);
+    SspPortId portId;
+    SendData* sendData;
+    SendData** link;
+
+    if (NULL == data)
+        return SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Remove from the reserved list and release the queue entry
+    sendData = FindReserved(data, &portId, &link);
+    if (NULL != sendData)
+    {
+        *link = sendData->next;
+        ASSERT_TRUE(self.claimedCnt[portId] > 0);
+        self.claimedCnt[portId]--;
+    }
+
+    SSPOSAL_LockPut(self.hSspLock);
+
+    if (NULL == sendData)
+        return SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
+
+    FreeSendData(sendData);
+    return SSP_SUCCESS;
 }
 
 /// Register to listen for incoming data on a socket. Called when either: a
@@ -840,6 +2961,55 @@ SspErr SSP_Listen(UINT8 socketId, SspDataCallback callback, void* userData)
     return err;
 }
 
+/// Take ownership of the data passed to a SSP_RECEIVE listener callback. Must 
+/// be called during the callback. The data remains valid after the callback 
+/// returns until released using SSP_ReleaseRecv(), allowing the data to be 
+/// handed to another thread without a copy. Up to SSP_RECV_BUFFERS - 1 
+/// receive buffers may be retained at once. Reassembled fragmented messages 
+/// and messages held for in order delivery cannot be retained.
+/// @param[in] data The data pointer passed to the callback.
+/// @param[out] handle The handle used to release the data.
+/// @return SSP_SUCCESS if success. SSP_OUT_OF_MEMORY if no receive buffer 
+///     is available; the data must be copied instead.
+SspErr SSP_RetainRecv(const void* data, SspRecvHandle* handle)
+{
+    const SspData* sspData = NULL;
+    SspData* retained;
+    INT16 portId;
+
+    if (NULL == data || NULL == handle)
+        return SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
+    *handle = NULL;
+
+    // Find the port whose current callback received the data
+    for (portId = SSP_PORT1; portId < SSP_MAX_PORTS; portId++)
+    {
+        sspData = self.recvCallbackData[portId];
+        if (NULL != sspData && 
+            sspData->packet.body + GetExtSize(sspData->packet.header.type) == data)
+            break;
+    }
+    if (portId >= SSP_MAX_PORTS)
+        return SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
+
+    // Take the receive buffer from the port parser
+    retained = SSPCOM_RetainRecvData((SspPortId)portId, sspData);
+    if (NULL == retained)
+        return SSPCMN_ReportErr(SSP_OUT_OF_MEMORY);
+    ASSERT_TRUE(retained == sspData);
+
+    self.recvCallbackData[portId] = NULL;
+    *handle = retained;
+    return SSP_SUCCESS;
+}
+
+/// Release received data retained using SSP_RetainRecv(). 
+/// @param[in] handle The handle returned by SSP_RetainRecv().
+void SSP_ReleaseRecv(SspRecvHandle handle)
+{
+    SSPCOM_ReleaseRecvData(handle);
+}
+
 /// Get the number of messages in the send queue. 
 /// @param[in] portId A port identifier.
 /// @return The number of messages in the queue.
@@ -849,48 +3019,173 @@ UINT16 SSP_GetSendQueueSize(SspPortId portId)
     return size;
 }
 
+/// Get the fixed block memory pool usage statistics. Use the high-water marks
+/// to size SSP_MAX_MESSAGES and the SspData size class pools. A failed 
+/// SspData size class allocation falls back to the next larger pool.
+/// @param[out] stats An array to receive the statistics of each pool.
+/// @param[in] maxStats The number of stats array elements.
+/// @return The number of pools written to stats. 0 if the fixed block 
+/// allocator is not used.
+UINT16 SSP_GetMemStats(SspMemStats* stats, UINT16 maxStats)
+{
+    UINT16 numStats = 0;
+#ifdef USE_FB_ALLOCATOR
+    ALLOC_HANDLE hAllocs[MAX_MEM_POOLS];
+    ALLOC_Stats allocStats;
+    UINT16 numAllocs;
+    UINT16 i;
+
+    if (!stats)
+        return 0;
+
+    for (numAllocs = 0; numAllocs < SEND_DATA_CLASSES; numAllocs++)
+        hAllocs[numAllocs] = *sendDataClasses[numAllocs].hAlloc;
+#ifdef USE_SSP_FRAGMENTATION
+    hAllocs[numAllocs++] = sendFragAllocator;
+#endif
+    numAllocs += SSPCOM_GetAllocators(&hAllocs[numAllocs], 
+        (UINT16)(sizeof(hAllocs) / sizeof(hAllocs[0]) - numAllocs));
+
+    for (i = 0; i < numAllocs && numStats < maxStats; i++)
+    {
+        ALLOC_GetStats(hAllocs[i], &allocStats);
+
+        stats[numStats].name = allocStats.name;
+        stats[numStats].blockSize = allocStats.blockSize;
+        stats[numStats].maxBlocks = allocStats.maxBlocks;
+        stats[numStats].blocksInUse = allocStats.blocksInUse;
+        stats[numStats].maxBlocksInUse = allocStats.maxBlocksInUse;
+        stats[numStats].allocations = allocStats.allocations;
+        stats[numStats].deallocations = allocStats.deallocations;
+        stats[numStats].failedAllocations = allocStats.failedAllocations;
+        numStats++;
+    }
+#endif
+    return numStats;
+}
+
+/// Set the maximum number of unacknowledged messages in flight on a port. 
+/// A larger window pipelines outgoing messages instead of waiting for each
+/// ACK before sending the next message.
+/// @param[in] portId A port identifier.
+/// @param[in] windowSize The send window size (1 to SSP_MAX_MESSAGES, at most 64).
+/// @return SSP_SUCCESS if success.
+SspErr SSP_SetSendWindow(SspPortId portId, UINT16 windowSize)
+{
+    if (!self.initOnce)
+        return SSPCMN_ReportErr(SSP_NOT_INITIALIZED);
+
+    if (portId <= SSP_INVALID_PORT || portId >= SSP_MAX_PORTS)
+        return SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
+
+    if (windowSize < 1 || windowSize > MAX_SEND_WINDOW)
+        return SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+    self.sendWindow[portId] = windowSize;
+    SSPOSAL_LockPut(self.hSspLock);
+
+    return SSP_SUCCESS;
+}
+
+/// Set the frame check used to send packets on a port. The frame check is 
+/// flagged within each packet header so the remote CPU checks received packets
+/// using the same CRC. SSP_FRAME_CHECK_CRC32C requires USE_SSP_CRC32C.
+/// @param[in] portId A port identifier.
+/// @param[in] frameCheck The frame check to send with.
+/// @return SSP_SUCCESS if success.
+SspErr SSP_SetFrameCheck(SspPortId portId, SspFrameCheck frameCheck)
+{
+    SspErr err;
+
+    if (!self.initOnce)
+        return SSPCMN_ReportErr(SSP_NOT_INITIALIZED);
+
+    err = SSPCOM_SetFrameCheck(portId, frameCheck);
+    if (err != SSP_SUCCESS)
+        return SSPCMN_ReportErr(err);
+
+    return SSP_SUCCESS;
+}
+
 /// Get the receive queue empty status. 
 /// @param[in] portId A port identifier.
-/// @return TRUE if incoming receive queue is empty. 
+/// @return TRUE if incoming receive queue is empty and no received messages 
+///     are held for in order delivery. 
 BOOL SSP_IsRecvQueueEmpty(SspPortId portId)
 {
-    return SSPHAL_IsRecvQueueEmpty(portId);
+    BOOL empty = SSPCOM_IsRecvQueueEmpty(portId);
+    UINT16 i;
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Held messages are delivered by a later SSP_Process() call
+    for (i = 0; i < self.recvHoldCnt && empty; i++)
+    {
+        if (self.recvHold[i].portId == portId)
+            empty = FALSE;
+    }
+
+    SSPOSAL_LockPut(self.hSspLock);
+    return empty;
 }
 
 /// Called periodically from a single task or loop to process SSP packets.
 /// Clients registered with SSP_Listener() are called back from the context
 /// that calls this function. This function only needs to be called if there
-/// are outgoing or incoming data to be processed.
+/// are outgoing or incoming data to be processed. Receives up to 
+/// SSP_RECV_PACKET_BUDGET packets on each port per call.
 void SSP_Process()
+{
+    SSP_ProcessEx(SSP_RECV_PACKET_BUDGET, SSP_RECV_TIME_BUDGET);
+}
+
+/// Called periodically from a single task or loop to process SSP packets. 
+/// Receives up to the budget of packets on each port per call.
+/// @param[in] packetBudget The maximum number of packets to receive per port. 
+///     0 receives all available packets.
+/// @param[in] timeBudget The maximum time to spend receiving per port in mS. 
+///     0 is no limit.
+void SSP_ProcessEx(UINT16 packetBudget, UINT32 timeBudget)
 {
     UINT16 portId = 0;
-    BOOL powerSave = TRUE;
 
     // Iterate over all ports
     for (portId=SSP_PORT1; portId<SSP_MAX_PORTS; portId++)
-    {
-        // Is the port open?
-        if (SSPCOM_IsPortOpen((SspPortId)portId) == TRUE)
-        {
-            // Process incoming data on the specified port
-            ProcessReceive((SspPortId)portId);
+        ProcessPort((SspPortId)portId, packetBudget, timeBudget);
 
-            // Process outgoing data on the specified port
-            ProcessSend((SspPortId)portId);
+    // Can power savings be enabled?
+    if (IsSendIdle())
+    {
+        // Enable SSP power savings. No more outgoing messages.
+        SSPHAL_PowerSave(TRUE);
+    }
+}
 
-            // Messages still in outgoing list?
-            if (ListSize((SspPortId)portId) > 0)
-            {
-                // No power savings - still outgoing messages to process
-                powerSave = FALSE;
-            }
-        }
+/// Process SSP packets on one port. Each port may be processed by its own 
+/// task so a slow port does not delay the others. A port must only be 
+/// processed by one task at a time, either using this function or 
+/// SSP_Process(). Clients registered with SSP_Listen() are called back from 
+/// the context that processes the port of the socket.
+/// @param[in] portId A port identifier.
+/// @param[in] packetBudget The maximum number of packets to receive. 0 
+///     receives all available packets.
+/// @param[in] timeBudget The maximum time to spend receiving in mS. 0 is 
+///     no limit.
+void SSP_ProcessPort(SspPortId portId, UINT16 packetBudget, UINT32 timeBudget)
+{
+    if (portId <= SSP_INVALID_PORT || portId >= SSP_MAX_PORTS)
+    {
+        SSPCMN_ReportErr(SSP_BAD_ARGUMENT);
+        return;
     }
 
+    ProcessPort(portId, packetBudget, timeBudget);
+
     // Can power savings be enabled?
-    if (powerSave)
+    if (IsSendIdle())
     {
-        // Enable SSP power savings. No more outgoing messages.
+        // Enable SSP power savings. No more outgoing messages on any port.
         SSPHAL_PowerSave(TRUE);
     }
 }
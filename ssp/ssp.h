@@ -27,6 +27,9 @@ extern "C" {
 typedef void(*SspDataCallback)(UINT8 socketId, const void* data, UINT16 dataSize,
     SspDataType type, SspErr status, void* userData);
 
+/// Handle to received data retained by a listener using SSP_RetainRecv().
+typedef struct SspData* SspRecvHandle;
+
 // Called once per port to initialize
 SspErr SSP_Init(SspPortId portId);
 
@@ -46,18 +49,48 @@ SspErr SSP_Send(UINT8 srcSocketId, UINT8 destSocketId, const void* data, UINT16
 SspErr SSP_SendMultiple(UINT8 srcSocketId, UINT8 destSocketId, INT16 numData,
     void const** dataArray, UINT16* dataSizeArray);
 
+// Reserve an outgoing message to write data directly into the packet
+SspErr SSP_ReserveSend(UINT8 srcSocketId, UINT8 destSocketId, UINT16 dataSize, void** data);
+
+// Send a message reserved with SSP_ReserveSend()
+SspErr SSP_CommitSend(void* data, UINT16 dataSize);
+
+// Release a message reserved with SSP_ReserveSend() without sending
+SspErr SSP_CancelSend(void* data);
+
 // Listen for incoming data on a socket using a callback function
 SspErr SSP_Listen(UINT8 socketId, SspDataCallback callback, void* userData);
 
+// Take ownership of received data during a SSP_RECEIVE callback
+SspErr SSP_RetainRecv(const void* data, SspRecvHandle* handle);
+
+// Release received data retained with SSP_RetainRecv()
+void SSP_ReleaseRecv(SspRecvHandle handle);
+
 // Get number of pending messages in outgoing queue
 UINT16 SSP_GetSendQueueSize(SspPortId portId);
 
+// Get the memory pool usage statistics
+UINT16 SSP_GetMemStats(SspMemStats* stats, UINT16 maxStats);
+
+// Set the maximum number of unacknowledged outgoing messages on a port
+SspErr SSP_SetSendWindow(SspPortId portId, UINT16 windowSize);
+
+// Set the frame check (CRC-16 or CRC-32C) used to send on a port
+SspErr SSP_SetFrameCheck(SspPortId portId, SspFrameCheck frameCheck);
+
 // Determine if the incoming queue has data or not
 BOOL SSP_IsRecvQueueEmpty(SspPortId portId);
 
 // Process outgoing and incoming socket messages
 void SSP_Process(void);
 
+// Process outgoing and incoming socket messages using a receive budget
+void SSP_ProcessEx(UINT16 packetBudget, UINT32 timeBudget);
+
+// Process outgoing and incoming socket messages on one port
+void SSP_ProcessPort(SspPortId portId, UINT16 packetBudget, UINT32 timeBudget);
+
 // Register for callbacks when SSP error occurs
 void SSP_SetErrorHandler(ErrorHandler handler);
 
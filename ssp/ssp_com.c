@@ -5,6 +5,7 @@
 #include "ssp_util.h"
 #include "ssp_crc.h"
 #include "ssp_fault.h"
+#include <string.h>
 #ifdef USE_FB_ALLOCATOR
 #include "fb_allocator.h"
 #else
@@ -22,48 +23,94 @@ typedef enum
     PS_TRANSACTION,
     PS_CHECKSUM,
     PS_BODY,
-    PS_FOOTER_1,
-    PS_FOOTER_2
+    PS_FOOTER
 } ParseState;
 
-typedef UINT16 SspPacketFooterType;
-
-// Maximum number of SspData fixed blocks
-#define MAX_SSP_DATA_BLOCKS     SSP_MAX_MESSAGES
+typedef UINT32 SspPacketFooterType;
 
 #ifndef MAX_PORT_RECV_BYTES
 // Maximum number of bytes to read from communication port on each
-// call to SSPHAL_PortRecv()
-#define MAX_PORT_RECV_BYTES     1
-
-// If communication port driver guarantees one full SSP message when
-// SSPHAL_PortRecv() called (like maybe a DMA SPI driver)
-//#define MAX_PORT_RECV_BYTES     SSP_PACKET_SIZE(SSP_MAX_BODY_SIZE)
+// call to SSPHAL_PortRecv(). Bytes following a complete packet are kept 
+// in the port receive buffer for the next packet.
+#define MAX_PORT_RECV_BYTES     SSP_PACKET_SIZE(SSP_MAX_BODY_SIZE)
 #endif   //#ifndef MAX_PORT_RECV_BYTES
 
-// Define the fixed block allocator and memory for dynamic SspData. Add +1 to number 
-// of blocks to account for one dedicated block for receiving data (i.e. self.sspDataRecv).
+#ifndef SSP_RECV_BUFFERS
+// Number of receive buffers. Listeners may retain up to SSP_RECV_BUFFERS - 1.
+#define SSP_RECV_BUFFERS        2
+#endif
+
+// Define the fixed block allocator and memory for dynamic SspData. One block per
+// port for receiving data (i.e. sspDataRecv) and SSP_RECV_BUFFERS - 1 for receive 
+// data retained by listeners. Outgoing SspData is stored within SendData blocks.
 #ifdef USE_FB_ALLOCATOR
-ALLOC_DEFINE(sspDataAllocator, SSP_DATA_SIZE(SSP_MAX_BODY_SIZE), MAX_SSP_DATA_BLOCKS + 1)
+ALLOC_DEFINE(sspDataAllocator, ALLOC_ROUND_UP(SSP_DATA_SIZE(SSP_MAX_BODY_SIZE), 8), 
+    SSP_MAX_PORTS + SSP_RECV_BUFFERS - 1)
 #endif
 
 // First 2 packet header synchronization bytes
 #define SIG_1   0xBE
 #define SIG_2   0xEF
 
+// Frame check seed selected by the packet header type field
+#define FRAME_CHECK_SEED(_type_)    (((_type_) & SSP_FLAG_CRC32C) ? 0 : 0xFFFF)
+
+// Port receive buffer size. Holds one port read plus the lookback bytes of 
+// a partially received frame.
+#define RECV_BUFFER_SIZE    (MAX_PORT_RECV_BYTES + SSP_PACKET_SIZE(SSP_MAX_BODY_SIZE))
+
+// Port receive buffer holding bytes read but not yet parsed. Bytes of the 
+// current frame are kept before head for lookback. 
 typedef struct
 {
-    // Socket ID to port ID mapping
-    SspPortId socketToPortIdMap[SSP_SOCKET_MAX];
+    UINT8 data[RECV_BUFFER_SIZE];
+    UINT16 head;
+    UINT16 count;
+} RecvBuffer;
 
-    // Software lock
-    SSP_OSAL_HANDLE hSspLock;
+// Port receive and parse state
+typedef struct
+{
+    // Port receiving
+    SspPortId portId;
 
     // Parse data
     ParseState parseState;
     SspPacketFooterType currentFooter;
     SspData* sspDataRecv;
     UINT16 parseBytes;
+    UINT16 frameBytes;
+
+    // CRC computed as the frame bytes are parsed
+    SspPacketFooterType crc;
+
+    // Frame to a closed or unknown socket. The body is skipped, not buffered.
+    BOOL dropFrame;
+
+    // Bytes read but not yet parsed
+    RecvBuffer recvBuffer;
+} RecvContext;
+
+typedef struct
+{
+    // Socket ID to port ID mapping
+    SspPortId socketToPortIdMap[SSP_SOCKET_MAX];
+
+    // Software lock
+    SSP_OSAL_HANDLE hSspLock;
+
+    // Port receive contexts
+    RecvContext recv[SSP_MAX_PORTS];
+
+    // Receive buffers retained by listeners. Up to SSP_RECV_BUFFERS - 1 are used.
+    SspData* recvRetained[SSP_RECV_BUFFERS];
+    UINT16 recvRetainedCnt;
+
+    // Frame check used to send on each port
+    SspFrameCheck frameCheck[SSP_MAX_PORTS];
+
+    // Frame checks computed by each port HAL. Bit n is SspFrameCheck n.
+    UINT8 crcOffload[SSP_MAX_PORTS];
 
     // Set TRUE after one time initialization complete
     BOOL initOnce;
@@ -74,8 +121,13 @@ static SspComObj self;
 
 // Private functions
 static UINT8 Checksum(const UINT8* data, UINT16 dataSize);
-static void ParseReset(void);
-static BOOL Parse(const UINT8* buf, UINT16 bufSize, UINT16* bytesParsed);
+static SspPacketFooterType FrameCheck(SspPortId portId, UINT8 type, const UINT8* data, UINT16 dataSize, SspPacketFooterType crc);
+static SspErr CheckSocket(UINT8 socketId);
+static void ParseReset(RecvContext* ctx);
+static void ParseHeader(RecvContext* ctx, const UINT8* header);
+static void ParseFooter(RecvContext* ctx, SspPacketFooterType footer);
+static BOOL ParseFrame(RecvContext* ctx, const UINT8* buf, UINT16 bufSize, UINT16* bytesParsed);
+static BOOL Parse(RecvContext* ctx, const UINT8* buf, UINT16 bufSize, UINT16* bytesParsed);
 static SspErr Receive(SspPortId portId, const SspData** sspData, UINT16 timeout);
 
 /// Compute 8-bit checksum.
@@ -90,267 +142,413 @@ static UINT8 Checksum(const UINT8* data, UINT16 dataSize)
     return sum;
 }
 
-/// Receive data on a port. 
+/// Compute the frame CRC selected by the packet header type field. The port 
+/// HAL computes the CRC if it supports offloading it.
+/// @param[in] portId A port identifier.
+/// @param[in] type The packet header type field.
+/// @param[in] data Data bytes to compute the CRC over.
+/// @param[in] dataSize Number of bytes pointed to by data argument.
+/// @param[in] crc The CRC of the preceding frame bytes or FRAME_CHECK_SEED().
+/// @return The CRC-16 or CRC-32C.
+static SspPacketFooterType FrameCheck(SspPortId portId, UINT8 type, const UINT8* data, UINT16 dataSize, SspPacketFooterType crc)
+{
+    SspFrameCheck frameCheck = (type & SSP_FLAG_CRC32C) ? SSP_FRAME_CHECK_CRC32C : SSP_FRAME_CHECK_CRC16;
+
+    if (self.crcOffload[portId] & (1 << frameCheck))
+        return SSPHAL_CrcCompute(portId, frameCheck, data, dataSize, crc);
+
+#ifdef USE_SSP_CRC32C
+    if (frameCheck == SSP_FRAME_CHECK_CRC32C)
+        return Crc32cCalcBlock(data, dataSize, crc);
+#endif
+    return Crc16CalcBlock((unsigned char*)data, dataSize, (unsigned short)crc);
+}
+
+/// Receive data on a port. When a frame fails, the bytes following the failed 
+/// frame start are parsed again to find a frame that started inside it.
 /// @param[in] portId A port identifier.
 /// @param[out] sspData The received data. 
 /// @param[in] timeout The timeout to receive data in mS.
 static SspErr Receive(SspPortId portId, const SspData** sspData, UINT16 timeout)
 {
-    const char* parseData = NULL;
-    static char dataRecv[MAX_PORT_RECV_BYTES];
+    RecvContext* ctx = &self.recv[portId];
+    RecvBuffer* recvBuffer = &ctx->recvBuffer;
     UINT16 bytesRead = 0;
     UINT16 bytesParsed = 0;
-    BOOL complete = TRUE; 
-    BOOL readFromPort = TRUE;
-    static const UINT16 PARSE_HISTORY_SIZE = sizeof(SspPacketHeader);
-    static char parseHistory[sizeof(SspPacketHeader)];
-    static UINT16 parseHistoryIdx = 0;
+    UINT16 frameBytes = 0;
+    BOOL complete = FALSE;
 
     if (NULL == sspData)
         return SSP_BAD_ARGUMENT;
 
     do
     {
-        if (readFromPort)
-        {
-            // Read data from port
-            SSPHAL_PortRecv(portId, dataRecv, &bytesRead, MAX_PORT_RECV_BYTES, timeout);
-            parseData = dataRecv;
-        }
-        else
+        // Receive buffer empty? Read as many bytes as the port has.
+        if (0 == recvBuffer->count)
         {
-            // Read data from parse history skipping first byte. Trying to relocate the sync bytes.
-            parseData = &parseHistory[1];
-            bytesRead = PARSE_HISTORY_SIZE - 1;
+            // Keep the bytes of a partially received frame for lookback
+            frameBytes = (ctx->parseState != PS_SIGNATURE_1) ? ctx->frameBytes : 0;
+            if (frameBytes > recvBuffer->head)
+                frameBytes = recvBuffer->head;
+            memmove(recvBuffer->data, &recvBuffer->data[recvBuffer->head - frameBytes], frameBytes);
+            recvBuffer->head = frameBytes;
 
-            // Reset history variables
-            readFromPort = TRUE;
-            parseHistoryIdx = 0;
-        }
+            bytesRead = 0;
+            SSPHAL_PortRecv(portId, (char*)&recvBuffer->data[frameBytes], &bytesRead, MAX_PORT_RECV_BYTES, timeout);
+            recvBuffer->count = bytesRead;
 
-        // Is there data to parse?
-        if (bytesRead > 0)
-        {
-            // Parse the packet data
-            complete = Parse((UINT8*)parseData, bytesRead, &bytesParsed);
+            // No more data to parse
+            if (0 == bytesRead)
+                break;
+        }
 
-            // Save parse data history incase need to reparse header
-            for (int i = 0; i < bytesRead; i++)
-            {
-                if (parseHistoryIdx >= PARSE_HISTORY_SIZE)
-                    break;
-                parseHistory[parseHistoryIdx++] = parseData[i];
-            }
+        // Parse the packet data
+        complete = Parse(ctx, &recvBuffer->data[recvBuffer->head], recvBuffer->count, &bytesParsed);
+        recvBuffer->head += bytesParsed;
+        recvBuffer->count -= bytesParsed;
 
-            // If checksum header is bad, need to backup and reparse the header data
-            // history and try to find sync bytes
-            if (complete && self.sspDataRecv->err == SSP_BAD_HEADER_CHECKSUM &&
-                parseHistoryIdx == PARSE_HISTORY_SIZE)
-            {
-                complete = FALSE;
-                readFromPort = FALSE;
-            }
-        }
-        else
+        // Frame failed? Rewind to the byte after the failed frame start and 
+        // rescan for the signature. A dropped frame passing the CRC is valid.
+        if (complete && ctx->sspDataRecv->err != SSP_SUCCESS && ctx->frameBytes > 1 &&
+            !(ctx->dropFrame && ctx->sspDataRecv->err != SSP_CORRUPTED_PACKET))
         {
-            // No more data to parse
-            break;
+            frameBytes = ctx->frameBytes - 1;
+            if (frameBytes > recvBuffer->head)
+                frameBytes = recvBuffer->head;
+            recvBuffer->head -= frameBytes;
+            recvBuffer->count += frameBytes;
+            ctx->frameBytes = 0;
+
+            // Header checksum failures are not reported. Keep parsing.
+            if (ctx->sspDataRecv->err == SSP_BAD_HEADER_CHECKSUM)
+                complete = FALSE;
         }
     } while (!complete);
 
     // Return a pointer to the internal receive structure
-    *sspData = self.sspDataRecv;
+    *sspData = ctx->sspDataRecv;
 
-    return self.sspDataRecv->err;
+    return ctx->sspDataRecv->err;
 }
 
 /// Reset the parser state machine.
-static void ParseReset(void)
+/// @param[in] ctx The port receive context.
+static void ParseReset(RecvContext* ctx)
 {
-    self.parseState = PS_SIGNATURE_1;
-    self.parseBytes = 0;
+    ctx->parseState = PS_SIGNATURE_1;
+    ctx->parseBytes = 0;
 } 
 
-/// Packet parser state machine. 
+/// Check a socket is valid and open.
+/// @param[in] socketId A socket identifier.
+/// @return SSP_SUCCESS if the socket is open. 
+static SspErr CheckSocket(UINT8 socketId)
+{
+    // Is the socket ID out of range?
+    if (socketId >= SSP_SOCKET_MAX)
+        return SSP_BAD_SOCKET_ID;
+
+    // Is the socket not open?
+    if (self.socketToPortIdMap[socketId] == SSP_INVALID_PORT)
+        return SSP_SOCKET_NOT_OPEN;
+
+    return SSP_SUCCESS;
+}
+
+/// Start the frame CRC and decide how to receive the frame body once the 
+/// header is validated. Frames to a closed or unknown socket are dropped.
+/// @param[in] ctx The port receive context.
+/// @param[in] header The validated packet header bytes.
+static void ParseHeader(RecvContext* ctx, const UINT8* header)
+{
+    UINT8 type = ((const SspPacketHeader*)header)->type;
+
+    ctx->crc = FrameCheck(ctx->portId, type, header, sizeof(SspPacketHeader), FRAME_CHECK_SEED(type));
+    ctx->currentFooter = 0;
+    ctx->dropFrame = (CheckSocket(((const SspPacketHeader*)header)->destId) != SSP_SUCCESS);
+}
+
+/// Validate the received packet footer and destination socket. The packet 
+/// header and body must already be received.
+/// @param[in] ctx The port receive context.
+/// @param[in] footer The received packet footer.
+static void ParseFooter(RecvContext* ctx, SspPacketFooterType footer)
+{
+    // CRC on incoming packet is computed while parsing
+    SspPacketFooterType crc = ctx->crc;
+
+    // Does computed and received CRC match?
+    if (footer != crc)
+    {
+        // Corrupted packet
+        ctx->sspDataRecv->err = SSP_CORRUPTED_PACKET;
+    }
+    else if (ctx->dropFrame)
+    {
+        // Valid packet to a closed or unknown socket. Body was not received.
+        ctx->sspDataRecv->err = CheckSocket(ctx->sspDataRecv->packet.header.destId);
+        if (SSP_SUCCESS == ctx->sspDataRecv->err)
+            ctx->sspDataRecv->err = SSP_SOCKET_NOT_OPEN;
+    }
+    else
+    {
+        // Socket closed while receiving?
+        ctx->sspDataRecv->err = CheckSocket(ctx->sspDataRecv->packet.header.destId);
+
+        // Packet received successfully
+        if (SSP_SUCCESS == ctx->sspDataRecv->err)
+            ctx->sspDataRecv->crc = crc;
+    }
+}
+
+/// Fast path parser for frames received whole within one buffer. Scans for the
+/// signature using memchr(), validates the header in one step and copies the 
+/// body with memcpy(). Must only be called when the state machine is waiting 
+/// for a new packet.
+/// @param[in] ctx The port receive context.
+/// @param[in] buf Data to parse.
+/// @param[in] bufSize Size of data to parse. 
+/// @param[out] bytesParsed The number of bytes parsed. Unparsed bytes hold the
+///     start of a frame split across buffers and are parsed by the state machine.
+/// @return TRUE if parsing complete either by success or failure.
+static BOOL ParseFrame(RecvContext* ctx, const UINT8* buf, UINT16 bufSize, UINT16* bytesParsed)
+{
+    const UINT8* end = buf + bufSize;
+    const UINT8* start = buf;
+    const UINT8* frame;
+    SspPacketFooterType footer;
+    UINT16 frameSize;
+    UINT16 footerSize;
+    UINT16 i;
+    UINT8 bodySize;
+
+    ctx->sspDataRecv->err = SSP_PARTIAL_PACKET;
+
+    while (start < end)
+    {
+        // Find the first signature byte
+        frame = (const UINT8*)memchr(start, SIG_1, (size_t)(end - start));
+        if (NULL == frame)
+        {
+            // No signature. Discard all data.
+            ctx->sspDataRecv->err = SSP_BAD_SIGNATURE;
+            start = end;
+            break;
+        }
+
+        // Frame header split across buffers? 
+        if (end - frame < (INT32)sizeof(SspPacketHeader))
+        {
+            start = frame;
+            break;
+        }
+
+        // Is the signature and header checksum valid? Otherwise resync on next byte.
+        if (frame[1] != SIG_2 ||
+            frame[sizeof(SspPacketHeader) - 1] != Checksum(frame, sizeof(SspPacketHeader) - sizeof(UINT8)))
+        {
+            start = frame + 1;
+            continue;
+        }
+
+        // Is incoming body data within the max allowable size?
+        bodySize = ((const SspPacketHeader*)frame)->bodySize;
+        if (bodySize > SSP_MAX_BODY_SIZE)
+        {
+            // Body too large
+            memcpy(&ctx->sspDataRecv->packet.header, frame, sizeof(SspPacketHeader));
+            ctx->sspDataRecv->err = SSP_PACKET_TOO_LARGE;
+            ctx->frameBytes = sizeof(SspPacketHeader);
+            *bytesParsed = (UINT16)(frame - buf) + sizeof(SspPacketHeader);
+            return TRUE;
+        }
+
+        // Frame body or footer split across buffers?
+        footerSize = SSP_FOOTER_SIZE(((const SspPacketHeader*)frame)->type);
+        frameSize = sizeof(SspPacketHeader) + bodySize + footerSize;
+        if (end - frame < frameSize)
+        {
+            start = frame;
+            break;
+        }
+
+        // Compute the CRC, copy header and body then validate footer (little-endian). 
+        // A dropped frame body is not copied.
+        ParseHeader(ctx, frame);
+        ctx->crc = FrameCheck(ctx->portId, ((const SspPacketHeader*)frame)->type, 
+            &frame[sizeof(SspPacketHeader)], bodySize, ctx->crc);
+        memcpy(&ctx->sspDataRecv->packet.header, frame, 
+            sizeof(SspPacketHeader) + (ctx->dropFrame ? 0 : bodySize));
+        footer = 0;
+        for (i = frameSize; i > frameSize - footerSize; i--)
+            footer = (footer << 8) | frame[i - 1];
+        ParseFooter(ctx, footer);
+        ctx->frameBytes = frameSize;
+
+        *bytesParsed = (UINT16)(frame - buf) + frameSize;
+        return TRUE;
+    }
+
+    *bytesParsed = (UINT16)(start - buf);
+    return FALSE;
+}
+
+/// Packet parser. Complete frames use the ParseFrame() fast path. Frames split
+/// across buffers use the byte state machine.
+/// @param[in] ctx The port receive context.
 /// @param[in] buf Data to parse.
 /// @param[in] bufSize Size of data to parse. 
 /// @param[out] bytesParsed The number of bytes parsed.
 /// @return TRUE if parsing complete either by success or failure.
-static BOOL Parse(const UINT8* buf, UINT16 bufSize, UINT16* bytesParsed)
+static BOOL Parse(RecvContext* ctx, const UINT8* buf, UINT16 bufSize, UINT16* bytesParsed)
 {
     BOOL parseComplete = FALSE;
     const UINT8* p;
-    SspPacketFooterType crc = 0;
-    UINT8* body = NULL;
+    UINT16 run;
 
     if (buf == NULL || bytesParsed == NULL || bufSize == 0)
         return TRUE;
 
+    *bytesParsed = 0;
+
+    // Waiting for a new packet? Try the fast path first.
+    if (ctx->parseState == PS_SIGNATURE_1)
+    {
+        if (ParseFrame(ctx, buf, bufSize, bytesParsed))
+            return TRUE;
+    }
+
     // Iterate over all bytes in the buffer or until parseComplete is TRUE
-    for (p = buf, *bytesParsed = 0; !parseComplete && *bytesParsed<bufSize; p++, (*bytesParsed)++)
+    for (p = buf + *bytesParsed; !parseComplete && *bytesParsed<bufSize; p++, (*bytesParsed)++)
     {
+        // Count the bytes received since the frame start
+        if (ctx->parseState == PS_SIGNATURE_1 || (ctx->parseState == PS_SIGNATURE_2 && *p == SIG_1))
+            ctx->frameBytes = 0;
+        ctx->frameBytes++;
+
         // SSP packet parse state machine
-        switch (self.parseState)
+        switch (ctx->parseState)
         {
         case PS_SIGNATURE_1:
-            self.sspDataRecv->err = SSP_PARTIAL_PACKET;
-            self.sspDataRecv->packet.header.sig[0] = SIG_1;
-            self.sspDataRecv->packet.header.sig[1] = SIG_2;
+            ctx->sspDataRecv->err = SSP_PARTIAL_PACKET;
+            ctx->sspDataRecv->packet.header.sig[0] = SIG_1;
+            ctx->sspDataRecv->packet.header.sig[1] = SIG_2;
             if (*p == SIG_1)
             {
-                self.parseState = PS_SIGNATURE_2;
+                ctx->parseState = PS_SIGNATURE_2;
             }
             else
             {
-                self.sspDataRecv->err = SSP_BAD_SIGNATURE;
-                ParseReset();
+                ctx->sspDataRecv->err = SSP_BAD_SIGNATURE;
+                ParseReset(ctx);
             }
             break;
         case PS_SIGNATURE_2:
             if (*p == SIG_2)
             {
-                self.parseState = PS_DESTINATION;
+                ctx->parseState = PS_DESTINATION;
             }
             else if (*p == SIG_1)
             {
-                self.parseState = PS_SIGNATURE_2;
+                ctx->parseState = PS_SIGNATURE_2;
             }
             else
             {
-                self.sspDataRecv->err = SSP_BAD_SIGNATURE;
-                ParseReset();
+                ctx->sspDataRecv->err = SSP_BAD_SIGNATURE;
+                ParseReset(ctx);
             }
             break;
         case PS_DESTINATION:
-            self.sspDataRecv->packet.header.destId = *p;
-            self.parseState = PS_SOURCE;
+            ctx->sspDataRecv->packet.header.destId = *p;
+            ctx->parseState = PS_SOURCE;
             break;
         case PS_SOURCE:
-            self.sspDataRecv->packet.header.srcId = *p;
-            self.parseState = PS_TYPE;
+            ctx->sspDataRecv->packet.header.srcId = *p;
+            ctx->parseState = PS_TYPE;
             break;
         case PS_TYPE:
-            self.sspDataRecv->packet.header.type = *p;
-            self.parseState = PS_BODY_SIZE;
+            ctx->sspDataRecv->packet.header.type = *p;
+            ctx->parseState = PS_BODY_SIZE;
             break;
         case PS_BODY_SIZE:
-            self.sspDataRecv->packet.header.bodySize = *p;
-            self.parseState = PS_TRANSACTION;
+            ctx->sspDataRecv->packet.header.bodySize = *p;
+            ctx->parseState = PS_TRANSACTION;
             break;
         case PS_TRANSACTION:
-            self.sspDataRecv->packet.header.transId = *p;
-            self.parseState = PS_CHECKSUM;
+            ctx->sspDataRecv->packet.header.transId = *p;
+            ctx->parseState = PS_CHECKSUM;
             break;
         case PS_CHECKSUM:
             // Is header checksum valid?
-            self.sspDataRecv->packet.header.checksum = *p;
-            if (*p == Checksum((UINT8*)&self.sspDataRecv->packet.header, sizeof(SspPacketHeader)-sizeof(UINT8)))
+            ctx->sspDataRecv->packet.header.checksum = *p;
+            if (*p == Checksum((UINT8*)&ctx->sspDataRecv->packet.header, sizeof(SspPacketHeader)-sizeof(UINT8)))
             {
                 // Valid header checksum
-                self.sspDataRecv->err = SSP_PARTIAL_PACKET_HEADER_VALID;
+                ctx->sspDataRecv->err = SSP_PARTIAL_PACKET_HEADER_VALID;
 
                 // Is incoming body data within the max allowable size?
-                if (self.sspDataRecv->packet.header.bodySize <= SSP_MAX_BODY_SIZE)
+                if (ctx->sspDataRecv->packet.header.bodySize <= SSP_MAX_BODY_SIZE)
                 {
-                    self.parseState = PS_BODY;
+                    ParseHeader(ctx, (const UINT8*)&ctx->sspDataRecv->packet.header);
+                    ctx->parseState = PS_BODY;
                 }
                 else
                 {
                     // Body too large
-                    self.sspDataRecv->err = SSP_PACKET_TOO_LARGE;
-                    ParseReset();
+                    ctx->sspDataRecv->err = SSP_PACKET_TOO_LARGE;
+                    ParseReset(ctx);
                     parseComplete = TRUE;
                 }
             }
             else
             {
                 // Invalid header checksum
-                self.sspDataRecv->err = SSP_BAD_HEADER_CHECKSUM;
-                ParseReset();
+                ctx->sspDataRecv->err = SSP_BAD_HEADER_CHECKSUM;
+                ParseReset(ctx);
                 parseComplete = TRUE;
             }
             break;
         case PS_BODY:
-            if (self.sspDataRecv->packet.header.bodySize)
+            if (ctx->sspDataRecv->packet.header.bodySize)
             {
-                // Get body pointer
-                body = (UINT8*)(self.sspDataRecv->packet.body);
-                if (body)
+                // Consume all available body bytes and update the CRC. A dropped 
+                // frame body is not buffered.
+                run = ctx->sspDataRecv->packet.header.bodySize - ctx->parseBytes;
+                if (run > bufSize - *bytesParsed)
+                    run = bufSize - *bytesParsed;
+                if (!ctx->dropFrame)
+                    memcpy(&ctx->sspDataRecv->packet.body[ctx->parseBytes], p, run);
+                ctx->crc = FrameCheck(ctx->portId, ctx->sspDataRecv->packet.header.type, p, run, ctx->crc);
+                ctx->parseBytes += run;
+                ctx->frameBytes += run - 1;
+                p += run - 1;
+                *bytesParsed += run - 1;
+                if (ctx->parseBytes >= ctx->sspDataRecv->packet.header.bodySize)
                 {
-                    body[self.parseBytes] = *p;
-                    if (++self.parseBytes >= self.sspDataRecv->packet.header.bodySize)
-                    {
-                        self.parseState = PS_FOOTER_1;
-                    }
-                }
-                else
-                {
-                    // Body pointer was null but header bodySize was not 0.
-                    // This should never happen.
-                    self.sspDataRecv->err = SSP_PARSE_ERROR;
-                    ParseReset();
-                    parseComplete = TRUE;
+                    ctx->parseState = PS_FOOTER;
                 }
                 break;
             }
             else
             {
-                self.parseState = PS_FOOTER_1;
+                ctx->parseState = PS_FOOTER;
             }
             // Fall through.
-        case PS_FOOTER_1:
-            self.currentFooter = *p;
-            self.parseState = PS_FOOTER_2;
-            break;
-        case PS_FOOTER_2:
-        {
-            // Is the socket ID out of range?
-            if (self.sspDataRecv->packet.header.destId >= SSP_SOCKET_MAX)
-            {
-                // Socket is not valid error
-                self.sspDataRecv->err = SSP_BAD_SOCKET_ID;
-            }
-            else if (self.socketToPortIdMap[self.sspDataRecv->packet.header.destId] == SSP_INVALID_PORT)
-            {
-                // Socket is not open error
-                self.sspDataRecv->err = SSP_SOCKET_NOT_OPEN;
-            }
-            else
+        case PS_FOOTER:
+            // Footer is little-endian. Bytes are counted following the body.
+            ctx->currentFooter |= (SspPacketFooterType)*p << 
+                (8 * (ctx->parseBytes++ - ctx->sspDataRecv->packet.header.bodySize));
+            if ((UINT16)(ctx->parseBytes - ctx->sspDataRecv->packet.header.bodySize) >= 
+                SSP_FOOTER_SIZE(ctx->sspDataRecv->packet.header.type))
             {
-                // Packet received.
-
-                // Compute CRC on incoming packet header
-                self.currentFooter += (UINT16)*p << 8;
-                crc = Crc16CalcBlock((unsigned char*)&self.sspDataRecv->packet.header,
-                    sizeof(SspPacketHeader) + self.sspDataRecv->packet.header.bodySize, 0xFFFF);
-
-                // If not little-endian
-                if (!LE())
-                {
-                    // Convert CRC to little-endian
-                    crc = bswap16(crc);
-                }
-
-                // Does computed and received CRC match?
-                if (self.currentFooter == crc)
-                {
-                    // Packet received successfully
-                    self.sspDataRecv->err = SSP_SUCCESS;
-                    *self.sspDataRecv->crc = crc;
-                }
-                else
-                {
-                    // Corrupted packet
-                    self.sspDataRecv->err = SSP_CORRUPTED_PACKET;
-                }
+                ParseFooter(ctx, ctx->currentFooter);
+                ParseReset(ctx);
+                parseComplete = TRUE;
             }
-            ParseReset();
-            parseComplete = TRUE;
             break;
-        }
         default:
             ASSERT();
-            ParseReset();
+            ParseReset(ctx);
         }
     }
 
@@ -362,6 +560,7 @@ static BOOL Parse(const UINT8* buf, UINT16 bufSize, UINT16* bytesParsed)
 /// @return SSP_SUCCESS if success. 
 SspErr SSPCOM_Init(SspPortId portId)
 {
+    RecvContext* ctx = &self.recv[portId];
     SspErr err = SSP_SUCCESS;
     BOOL success;
 
@@ -372,36 +571,67 @@ SspErr SSPCOM_Init(SspPortId portId)
         self.initOnce = TRUE;
 
         SSPOSAL_Init();
+        Crc16Init();
+#ifdef USE_SSP_CRC32C
+        Crc32cInit();
+#endif
 
-        self.parseState = PS_SIGNATURE_1;
         self.hSspLock = SSPOSAL_LockCreate();
+    }
 
-        // Allocate a SspData structure
-        self.sspDataRecv = SSPCOM_AllocateSspData(SSP_MAX_BODY_SIZE);
-        ASSERT_TRUE(self.sspDataRecv);
-        if (self.sspDataRecv)
+    // Allocate the port SspData receive structure
+    if (NULL == ctx->sspDataRecv)
+    {
+        ctx->sspDataRecv = SSPCOM_AllocateSspData(SSP_MAX_BODY_SIZE);
+        ASSERT_TRUE(ctx->sspDataRecv);
+        if (ctx->sspDataRecv)
         {
-            self.sspDataRecv->type = SSP_RECEIVE;
+            ctx->sspDataRecv->type = SSP_RECEIVE;
         }
     }
 
+    // Send using the CRC-16 frame check until changed
+    self.frameCheck[portId] = SSP_FRAME_CHECK_CRC16;
+    ctx->portId = portId;
+
+    // Reset the parser and empty the port receive buffer
+    ParseReset(ctx);
+    ctx->recvBuffer.head = 0;
+    ctx->recvBuffer.count = 0;
+
     // Open the SSP port
     success = SSPHAL_PortOpen(portId);
     if (success == FALSE)
         err = SSP_PORT_OPEN_FAILED;
 
+    // Use the port CRC offload if supported
+    self.crcOffload[portId] = 0;
+    if (SSPHAL_CrcOffloadSupported(portId, SSP_FRAME_CHECK_CRC16))
+        self.crcOffload[portId] |= 1 << SSP_FRAME_CHECK_CRC16;
+#ifdef USE_SSP_CRC32C
+    if (SSPHAL_CrcOffloadSupported(portId, SSP_FRAME_CHECK_CRC32C))
+        self.crcOffload[portId] |= 1 << SSP_FRAME_CHECK_CRC32C;
+#endif
+
     return err;
 }
 
 /// Terminate and cleanup resources. 
 void SSPCOM_Term(void)
 {
-    if (self.sspDataRecv != NULL)
+    for (UINT16 portId = 0; portId < SSP_MAX_PORTS; portId++)
     {
-        SSPCOM_DeallocateSspData(self.sspDataRecv);
-        self.sspDataRecv = NULL;
+        if (self.recv[portId].sspDataRecv != NULL)
+        {
+            SSPCOM_DeallocateSspData(self.recv[portId].sspDataRecv);
+            self.recv[portId].sspDataRecv = NULL;
+        }
     }
 
+    // Free receive buffers still retained by listeners
+    while (self.recvRetainedCnt > 0)
+        SSPCOM_DeallocateSspData(self.recvRetained[--self.recvRetainedCnt]);
+
     SSPOSAL_LockDestroy(self.hSspLock);
     self.hSspLock = SSP_OSAL_INVALID_HANDLE_VALUE;
 
@@ -440,6 +670,20 @@ void SSPCOM_DeallocateSspData(SspData* sspData)
 #endif
 }
 
+/// Get the SspData fixed block allocator handles.
+/// @param[out] hAllocs An array to receive the allocator handles.
+/// @param[in] maxAllocs The number of hAllocs array elements.
+/// @return The number of handles written to hAllocs.
+UINT16 SSPCOM_GetAllocators(void** hAllocs, UINT16 maxAllocs)
+{
+    UINT16 numAllocs = 0;
+#ifdef USE_FB_ALLOCATOR
+    if (numAllocs < maxAllocs)
+        hAllocs[numAllocs++] = sspDataAllocator;
+#endif
+    return numAllocs;
+}
+
 /// Initialize SspData structure.
 /// @param[out] sspData The data to initialize.
 /// @param[in] dataSize The packet body size.
@@ -447,12 +691,9 @@ SspData* SSPCOM_InitSspData(SspData* sspData, UINT16 dataSize)
 {
     ASSERT_TRUE(sspData);
 
-    // Set packet size
+    // Set packet size. The footer size is set when sent.
     sspData->packetSize = SSP_PACKET_SIZE(dataSize);
 
-    // Point the CRC at the end of client data
-    sspData->crc = (UINT16*)&sspData->packet.body[dataSize];
-
     return sspData;
 }
 
@@ -560,6 +801,7 @@ SspErr SSPCOM_GetPortId(UINT8 socketId, SspPortId* portId)
 /// @erturn SSP_SUCCESS if success. 
 SspErr SSPCOM_Flush(SspPortId portId)
 {
+    self.recv[portId].recvBuffer.count = 0;
     SSPHAL_PortFlush(portId);
     return SSP_SUCCESS;
 }
@@ -571,7 +813,6 @@ SspErr SSPCOM_Send(SspData* sspData)
 {
     SspPortId portId;
     SspErr err;
-    BOOL success;
 
     if (NULL == sspData)
         return SSP_BAD_ARGUMENT;
@@ -587,26 +828,45 @@ SspErr SSPCOM_Send(SspData* sspData)
     if (SSP_SUCCESS != err)
         return SSP_BAD_SOCKET_ID;
 
+    return SSPCOM_SendPort(portId, sspData);
+}
+
+/// Send data on a port. The source socket is not required to be open. 
+/// @param[in] portId A port identifier.
+/// @param[in] sspData The data to send.
+/// @return SSP_SUCCESS if success.
+SspErr SSPCOM_SendPort(SspPortId portId, SspData* sspData)
+{
+    SspPacketHeader* header;
+    SspErr err;
+    BOOL success;
+    UINT16 footerSize;
+
+    if (NULL == sspData)
+        return SSP_BAD_ARGUMENT;
+
     // Is port open?
     if (!SSPCOM_IsPortOpen(portId))
         return SSP_PORT_NOT_OPEN;
 
-    // Fill in the rest of the packet header
-    sspData->packet.header.sig[0] = SIG_1;
-    sspData->packet.header.sig[1] = SIG_2;
-    sspData->packet.header.checksum =
-        Checksum((UINT8*)&sspData->packet.header, sizeof(SspPacketHeader)-sizeof(UINT8));
+    // Fill in the rest of the packet header including the port frame check flag
+    header = &sspData->packet.header;
+    header->sig[0] = SIG_1;
+    header->sig[1] = SIG_2;
+    header->type &= ~SSP_FLAG_CRC32C;
+    if (self.frameCheck[portId] == SSP_FRAME_CHECK_CRC32C)
+        header->type |= SSP_FLAG_CRC32C;
+    header->checksum = Checksum((UINT8*)header, sizeof(SspPacketHeader)-sizeof(UINT8));
 
     // Compute the CRC for outgoing packet
-    *sspData->crc = Crc16CalcBlock((UINT8*)&sspData->packet.header,
-        sizeof(sspData->packet.header) + sspData->packet.header.bodySize, 0xFFFF);
+    sspData->crc = FrameCheck(portId, header->type, (UINT8*)header,
+        sizeof(SspPacketHeader) + header->bodySize, FRAME_CHECK_SEED(header->type));
 
-    // If not little-endian
-    if (!LE())
-    {
-        // Convert CRC to little-endian
-        *sspData->crc = bswap16(*sspData->crc);
-    }
+    // Write the footer little-endian following the body
+    footerSize = SSP_FOOTER_SIZE(header->type);
+    for (UINT16 i = 0; i < footerSize; i++)
+        sspData->packet.body[header->bodySize + i] = (UINT8)(sspData->crc >> (8 * i));
+    sspData->packetSize = sizeof(SspPacketHeader) + header->bodySize + footerSize;
 
     // Send the entire packet including header, body and CRC
     success = SSPHAL_PortSend(portId, (const char*)&sspData->packet, sspData->packetSize);
@@ -618,6 +878,100 @@ SspErr SSPCOM_Send(SspData* sspData)
     return err;
 }
 
+/// Set the frame check used to send on a port. Received packets are checked 
+/// using the frame check flagged within each packet header.
+/// @param[in] portId A port identifier.
+/// @param[in] frameCheck The frame check to send with.
+/// @return SSP_SUCCESS if success.
+SspErr SSPCOM_SetFrameCheck(SspPortId portId, SspFrameCheck frameCheck)
+{
+    if (portId <= SSP_INVALID_PORT || portId >= SSP_MAX_PORTS)
+        return SSP_BAD_ARGUMENT;
+
+#ifdef USE_SSP_CRC32C
+    if (frameCheck != SSP_FRAME_CHECK_CRC16 && frameCheck != SSP_FRAME_CHECK_CRC32C)
+        return SSP_BAD_ARGUMENT;
+#else
+    if (frameCheck != SSP_FRAME_CHECK_CRC16)
+        return SSP_BAD_ARGUMENT;
+#endif
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+    self.frameCheck[portId] = frameCheck;
+    SSPOSAL_LockPut(self.hSspLock);
+
+    return SSP_SUCCESS;
+}
+
+/// Take ownership of the receive data returned by the last SSPCOM_ProcessReceive()
+/// call on a port. A new receive buffer is used for subsequent packets on that port. 
+/// @param[in] portId The port the data was received on.
+/// @param[in] sspData The receive data returned by SSPCOM_ProcessReceive().
+/// @return The retained data or NULL if no receive buffer is available. Release 
+///     using SSPCOM_ReleaseRecvData().
+SspData* SSPCOM_RetainRecvData(SspPortId portId, const SspData* sspData)
+{
+    RecvContext* ctx;
+    SspData* sspDataRecv = NULL;
+    SspData* retained = NULL;
+
+    if (NULL == sspData || portId <= SSP_INVALID_PORT || portId >= SSP_MAX_PORTS)
+        return NULL;
+    ctx = &self.recv[portId];
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Is the data the port receive buffer and is a receive buffer available?
+    if (ctx->sspDataRecv == sspData && self.recvRetainedCnt < SSP_RECV_BUFFERS - 1)
+    {
+        sspDataRecv = SSPCOM_AllocateSspData(SSP_MAX_BODY_SIZE);
+        if (sspDataRecv)
+        {
+            sspDataRecv->type = SSP_RECEIVE;
+
+            // Swap in the new receive buffer
+            retained = ctx->sspDataRecv;
+            ctx->sspDataRecv = sspDataRecv;
+            self.recvRetained[self.recvRetainedCnt++] = retained;
+        }
+    }
+
+    SSPOSAL_LockPut(self.hSspLock);
+
+    return retained;
+}
+
+/// Release receive data retained using SSPCOM_RetainRecvData().
+/// @param[in] sspData The retained data. 
+void SSPCOM_ReleaseRecvData(SspData* sspData)
+{
+    UINT16 i;
+    BOOL found = FALSE;
+
+    if (NULL == sspData)
+        return;
+
+    SSPOSAL_LockGet(self.hSspLock, SSP_OSAL_WAIT_DEFAULT);
+
+    // Remove from the retained receive buffers
+    for (i = 0; i < self.recvRetainedCnt; i++)
+    {
+        if (self.recvRetained[i] == sspData)
+        {
+            self.recvRetained[i] = self.recvRetained[--self.recvRetainedCnt];
+            found = TRUE;
+            break;
+        }
+    }
+
+    SSPOSAL_LockPut(self.hSspLock);
+
+    // Not retained or already released?
+    ASSERT_TRUE(found);
+    if (found)
+        SSPCOM_DeallocateSspData(sspData);
+}
+
 /// Process incoming receive data. 
 /// @param[in] portId A port identifier.
 /// @param[out] sspData Incoming data. 
@@ -635,3 +989,14 @@ SspErr SSPCOM_ProcessReceive(SspPortId portId, const SspData** sspData, UINT16 t
     return err;
 }
 
+/// Get the receive queue empty status including bytes held in the port 
+/// receive buffer.
+/// @param[in] portId A port identifier.
+/// @return TRUE if no receive data is pending. 
+BOOL SSPCOM_IsRecvQueueEmpty(SspPortId portId)
+{
+    if (self.recv[portId].recvBuffer.count > 0)
+        return FALSE;
+    return SSPHAL_IsRecvQueueEmpty(portId);
+}
+
@@ -44,12 +44,30 @@ BOOL SSPCOM_IsSocketOpen(UINT8 socketId);
 // Send data over a socket
 SspErr SSPCOM_Send(SspData* sspData);
 
+// Send data on a port
+SspErr SSPCOM_SendPort(SspPortId portId, SspData* sspData);
+
+// Set the frame check used to send on a port
+SspErr SSPCOM_SetFrameCheck(SspPortId portId, SspFrameCheck frameCheck);
+
 // Flush data on a port
 SspErr SSPCOM_Flush(SspPortId portId);
 
 // Process receive data
 SspErr SSPCOM_ProcessReceive(SspPortId portId, const SspData** sspData, UINT16 timeout);
 
+// Get the receive queue empty status including buffered bytes
+BOOL SSPCOM_IsRecvQueueEmpty(SspPortId portId);
+
+// Take ownership of the last received data on a port
+SspData* SSPCOM_RetainRecvData(SspPortId portId, const SspData* sspData);
+
+// Release received data retained with SSPCOM_RetainRecvData()
+void SSPCOM_ReleaseRecvData(SspData* sspData);
+
+// Get the SspData fixed block allocator handles
+UINT16 SSPCOM_GetAllocators(void** hAllocs, UINT16 maxAllocs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,12 @@ typedef enum
     SSP_SEND
 } SspDataType;
 
+typedef enum
+{
+    SSP_FRAME_CHECK_CRC16,
+    SSP_FRAME_CHECK_CRC32C
+} SspFrameCheck;
+
 typedef enum
 {
     SSP_SUCCESS,
@@ -42,6 +48,19 @@ typedef enum
     SSP_SOFTWARE_FAULT
 } SspErr;
 
+// Fixed block memory pool usage statistics
+typedef struct
+{
+    const char* name;
+    UINT32 blockSize;
+    UINT32 maxBlocks;
+    UINT32 blocksInUse;
+    UINT32 maxBlocksInUse;
+    UINT64 allocations;
+    UINT64 deallocations;
+    UINT64 failedAllocations;
+} SspMemStats;
+
 
 // Error handler callback function signature
 typedef void(*ErrorHandler)(SspErr err);
@@ -13,14 +13,39 @@ SspErr SSPCMN_ReportErr(SspErr err);
 SspErr SSPCMN_GetLastErr(void);
 void SSPCMN_SetErrorHandler(ErrorHandler handler);
 
+// Maximum packet footer (i.e. CRC) size in bytes
+#ifdef USE_SSP_CRC32C
+#define SSP_MAX_FOOTER_SIZE     sizeof(UINT32)
+#else
+#define SSP_MAX_FOOTER_SIZE     sizeof(UINT16)
+#endif
+
 // Maximum client data payload size in bytes within an SSP packet
-#define SSP_MAX_BODY_SIZE	(SSP_MAX_PACKET_SIZE - sizeof(SspPacketHeader) - sizeof(UINT16))
+#define SSP_MAX_BODY_SIZE	(SSP_MAX_PACKET_SIZE - sizeof(SspPacketHeader) - SSP_MAX_FOOTER_SIZE)
 
 // Total SSP data size is SspData + body data + CRC
-#define SSP_DATA_SIZE(_size_)    (sizeof(SspData) + _size_ + sizeof(UINT16))
+#define SSP_DATA_SIZE(_size_)    (sizeof(SspData) + _size_ + SSP_MAX_FOOTER_SIZE)
 
 // Total SSP packet size is SspPacket + body data + plus CRC
-#define SSP_PACKET_SIZE(_size_)  (sizeof(SspPacket) + _size_ + sizeof(UINT16))
+#define SSP_PACKET_SIZE(_size_)  (sizeof(SspPacket) + _size_ + SSP_MAX_FOOTER_SIZE)
+
+// The packet header type field holds the packet type in the low bits. The high
+// bits are flags that indicate optional extension fields located at the start
+// of the packet body. Extension fields are included within the header bodySize.
+#define SSP_TYPE_MASK           0x0F
+
+// Extension field flags
+#define SSP_FLAG_EXT_SEQ        0x80    // 1-byte transaction ID high byte
+#define SSP_FLAG_FRAG           0x40    // 2-byte message size, 1-byte fragment index and count
+
+// Frame check flag. The packet footer is a 4-byte CRC-32C instead of a 2-byte CRC-16.
+#define SSP_FLAG_CRC32C         0x20
+
+// Get the packet footer size from the header type field
+#define SSP_FOOTER_SIZE(_type_) (((_type_) & SSP_FLAG_CRC32C) ? sizeof(UINT32) : sizeof(UINT16))
+
+// Get the packet type from the header type field
+#define SSP_PACKET_TYPE(_type_) ((_type_) & SSP_TYPE_MASK)
 
 // The SSP packet header data structure
 typedef struct
@@ -56,8 +81,8 @@ typedef struct SspData
     // Send or receive data type
     SspDataType type;
 
-    // Points to CRC location within SspPacket
-    UINT16* crc;
+    // CRC-16 or CRC-32C of the packet. Sent little-endian following the body.
+    UINT32 crc;
 
     // Total size of the SspPacket in bytes
     UINT16 packetSize;
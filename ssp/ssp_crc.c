@@ -1,5 +1,6 @@
-// 16-bit CRC implementation
+// 16-bit CRC and 32-bit CRC-32C implementation
 
+#include "ssp_opt.h"
 #include "ssp_crc.h"
 
 // Define USE_CRC_TABLE to use the table-based CRC calculation
@@ -36,6 +37,197 @@ const unsigned short crcccitt_table[] = {
 0xef1f,	0xff3e,	0xcf5d,	0xdf7c,	0xaf9b,	0xbfba,	0x8fd9,	0x9ff8,	0x6e17,	0x7e36,	
 0x4e55,	0x5e74,	0x2e93,	0x3eb2,	0x0ed1,	0x1ef0,	}; 
 
+#ifdef USE_SSP_CRC_SLICING
+
+// Carry-less multiply kernels. x86 uses PCLMULQDQ and ARMv8 uses PMULL.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CRC_CLMUL_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CRC_TARGET_CLMUL
+#else
+#include <cpuid.h>
+#include <immintrin.h>
+#define CRC_TARGET_CLMUL __attribute__((target("pclmul,ssse3")))
+#endif
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#define CRC_CLMUL_ARM
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+typedef unsigned short (*CrcKernel)(const unsigned char* crc_msg, int len, 
+    unsigned short crc);
+
+// Slicing tables. crcSliceTable[n][i] is the CRC of byte i followed by n + 1 
+// zero bytes. crcccitt_table is the first slice.
+static unsigned short crcSliceTable[7][256];
+
+// Folding constants x^128 mod P and x^192 mod P
+static unsigned short crcFoldK128;
+static unsigned short crcFoldK192;
+
+// Fastest kernel supported by the CPU. Selected by Crc16Init().
+static unsigned short Crc16CalcByte(const unsigned char* crc_msg, int len, unsigned short crc);
+static CrcKernel crcKernel = Crc16CalcByte;
+
+// Calculates a 16-bit CRC using one table lookup per byte
+static unsigned short Crc16CalcByte(const unsigned char* crc_msg, int len, 
+    unsigned short crc)
+{
+    while (len-- > 0) 
+        crc = (crc << 8) ^ crcccitt_table[(crc >> 8) ^ *crc_msg++];
+    return crc;
+}
+
+// Calculates a 16-bit CRC using slicing-by-8 and slicing-by-4 tables. Each 
+// table lookup within a block is independent of the others.
+static unsigned short Crc16CalcSlicing(const unsigned char* crc_msg, int len, 
+    unsigned short crc)
+{
+    const unsigned short (*t)[256] = (const unsigned short (*)[256])crcSliceTable;
+
+    while (len >= 8)
+    {
+        crc = t[6][(crc >> 8) ^ crc_msg[0]] ^ t[5][(crc & 0xFF) ^ crc_msg[1]] ^
+            t[4][crc_msg[2]] ^ t[3][crc_msg[3]] ^ t[2][crc_msg[4]] ^
+            t[1][crc_msg[5]] ^ t[0][crc_msg[6]] ^ crcccitt_table[crc_msg[7]];
+        crc_msg += 8;
+        len -= 8;
+    }
+    if (len >= 4)
+    {
+        crc = t[2][(crc >> 8) ^ crc_msg[0]] ^ t[1][(crc & 0xFF) ^ crc_msg[1]] ^
+            t[0][crc_msg[2]] ^ crcccitt_table[crc_msg[3]];
+        crc_msg += 4;
+        len -= 4;
+    }
+    return Crc16CalcByte(crc_msg, len, crc);
+}
+
+#if defined(CRC_CLMUL_X86)
+// Calculates a 16-bit CRC by folding 16 byte blocks with PCLMULQDQ. The CRC 
+// seed is added to the first message bits. The folded remainder is congruent 
+// to the message modulo the polynomial, so its CRC completes the calculation. 
+CRC_TARGET_CLMUL
+static unsigned short Crc16CalcClmul(const unsigned char* crc_msg, int len, 
+    unsigned short crc)
+{
+    const __m128i swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i k = _mm_set_epi64x(crcFoldK192, crcFoldK128);
+    __m128i acc;
+    unsigned char rem[16];
+
+    if (len < 32)
+        return Crc16CalcSlicing(crc_msg, len, crc);
+
+    // Load the first block as a big-endian 128-bit value and add the seed
+    acc = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)crc_msg), swap);
+    acc = _mm_xor_si128(acc, _mm_set_epi64x((long long)((unsigned long long)crc << 48), 0));
+    crc_msg += 16;
+    len -= 16;
+
+    // Fold: acc = acc_hi * (x^192 mod P) + acc_lo * (x^128 mod P) + block
+    while (len >= 16)
+    {
+        acc = _mm_xor_si128(_mm_clmulepi64_si128(acc, k, 0x11), _mm_clmulepi64_si128(acc, k, 0x00));
+        acc = _mm_xor_si128(acc, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)crc_msg), swap));
+        crc_msg += 16;
+        len -= 16;
+    }
+
+    _mm_storeu_si128((__m128i*)rem, _mm_shuffle_epi8(acc, swap));
+    crc = Crc16CalcSlicing(rem, sizeof(rem), 0);
+    return Crc16CalcSlicing(crc_msg, len, crc);
+}
+
+// Returns nonzero if the CPU supports PCLMULQDQ and SSSE3
+static int Crc16ClmulSupported(void)
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) && (info[2] & (1 << 9));
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+    return (ecx & bit_PCLMUL) && (ecx & bit_SSSE3);
+#endif
+}
+#elif defined(CRC_CLMUL_ARM)
+// Loads 16 bytes as a big-endian 128-bit value. Also converts back to bytes.
+static uint64x2_t Crc16LoadBE(const unsigned char* data)
+{
+    uint8x16_t v = vrev64q_u8(vld1q_u8(data));
+    return vreinterpretq_u64_u8(vextq_u8(v, v, 8));
+}
+
+// Calculates a 16-bit CRC by folding 16 byte blocks with PMULL. See 
+// Crc16CalcClmul().
+static unsigned short Crc16CalcClmul(const unsigned char* crc_msg, int len, 
+    unsigned short crc)
+{
+    uint64x2_t acc;
+    uint8x16_t v;
+    unsigned char rem[16];
+
+    if (len < 32)
+        return Crc16CalcSlicing(crc_msg, len, crc);
+
+    // Load the first block as a big-endian 128-bit value and add the seed
+    acc = Crc16LoadBE(crc_msg);
+    acc = veorq_u64(acc, vcombine_u64(vcreate_u64(0), vcreate_u64((uint64_t)crc << 48)));
+    crc_msg += 16;
+    len -= 16;
+
+    // Fold: acc = acc_hi * (x^192 mod P) + acc_lo * (x^128 mod P) + block
+    while (len >= 16)
+    {
+        acc = veorq_u64(
+            vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(acc, 1), (poly64_t)crcFoldK192)),
+            vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(acc, 0), (poly64_t)crcFoldK128)));
+        acc = veorq_u64(acc, Crc16LoadBE(crc_msg));
+        crc_msg += 16;
+        len -= 16;
+    }
+
+    v = vreinterpretq_u8_u64(acc);
+    v = vextq_u8(v, v, 8);
+    vst1q_u8(rem, vrev64q_u8(v));
+    crc = Crc16CalcSlicing(rem, sizeof(rem), 0);
+    return Crc16CalcSlicing(crc_msg, len, crc);
+}
+
+// Returns nonzero if the CPU supports PMULL
+static int Crc16ClmulSupported(void)
+{
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+#else
+    return 1;
+#endif
+}
+#endif
+
+// Returns x^n mod P
+static unsigned short Crc16XPow(int n)
+{
+    unsigned int r = 1;
+    while (n-- > 0)
+    {
+        r <<= 1;
+        if (r & 0x10000)
+            r ^= 0x11021;
+    }
+    return (unsigned short)r;
+}
+
+#endif // USE_SSP_CRC_SLICING
+
 // Calculates a 16-bit CRC using table method  
 // @param[in] crc_msg - pointer to data buffer.
 // @param[in] len - number of bytes in buffer.
@@ -45,13 +237,47 @@ const unsigned short crcccitt_table[] = {
 unsigned short Crc16CalcBlock(unsigned char* crc_msg, int len, 
     unsigned short crc) 
 { 
+#ifdef USE_SSP_CRC_SLICING
+    // Use the fastest kernel selected by Crc16Init()
+    return crcKernel(crc_msg, len, crc);
+#else
     // Table-based CRC computation is faster but requires a lookup table
 
     while (len--) 
         crc = (crc << 8) ^ crcccitt_table[(crc >> 8) ^ *crc_msg++];
     return(crc);
+#endif
 }  
 
+// Initialize the CRC module. Builds the slicing tables and selects the fastest
+// kernel supported by the CPU. Results are identical for every kernel.
+void Crc16Init(void)
+{
+#ifdef USE_SSP_CRC_SLICING
+    int n, i;
+    unsigned short prev;
+
+    for (i = 0; i < 256; i++)
+    {
+        prev = crcccitt_table[i];
+        for (n = 0; n < 7; n++)
+        {
+            prev = (prev << 8) ^ crcccitt_table[prev >> 8];
+            crcSliceTable[n][i] = prev;
+        }
+    }
+
+    crcFoldK128 = Crc16XPow(128);
+    crcFoldK192 = Crc16XPow(192);
+
+    crcKernel = Crc16CalcSlicing;
+#if defined(CRC_CLMUL_X86) || defined(CRC_CLMUL_ARM)
+    if (Crc16ClmulSupported())
+        crcKernel = Crc16CalcClmul;
+#endif
+#endif
+}
+
 #else
 
 // polynomial used in 16-bit CRC calculation
@@ -87,5 +313,159 @@ unsigned short Crc16CalcBlock(unsigned char *crc_msg, int len,
 
     return crc;  
 }
+
+// Initialize the CRC module
+void Crc16Init(void)
+{
+}
 #endif // USE_CRC_TABLE
 
+
+#ifdef USE_SSP_CRC32C
+
+// CRC-32C instruction kernels. x86 uses the SSE4.2 crc32 instruction and ARMv8 
+// uses the CRC32 extension.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CRC32C_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <nmmintrin.h>
+#define CRC32C_TARGET
+#else
+#include <cpuid.h>
+#include <nmmintrin.h>
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CRC32C_ARM
+#include <arm_acle.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+#include <string.h>
+
+// CRC-32C (Castagnoli) reflected polynomial 0x1EDC6F41
+#define CRC32C_POLY     0x82F63B78
+
+typedef UINT32 (*Crc32cKernel)(const unsigned char* crc_msg, int len, UINT32 crc);
+
+// Portable table. crc32c_table[i] is the CRC of byte i. Built by Crc32cInit().
+static UINT32 crc32c_table[256];
+
+// Fastest kernel supported by the CPU. Selected by Crc32cInit().
+static UINT32 Crc32cCalcTable(const unsigned char* crc_msg, int len, UINT32 crc);
+static Crc32cKernel crc32cKernel = Crc32cCalcTable;
+
+// Calculates a CRC-32C using one table lookup per byte. The crc argument and
+// return value are not inverted.
+static UINT32 Crc32cCalcTable(const unsigned char* crc_msg, int len, UINT32 crc)
+{
+    while (len-- > 0)
+        crc = (crc >> 8) ^ crc32c_table[(crc ^ *crc_msg++) & 0xFF];
+    return crc;
+}
+
+#if defined(CRC32C_X86)
+// Calculates a CRC-32C using the SSE4.2 crc32 instruction
+CRC32C_TARGET
+static UINT32 Crc32cCalcHw(const unsigned char* crc_msg, int len, UINT32 crc)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    unsigned long long crc64 = crc;
+    unsigned long long data;
+
+    while (len >= 8)
+    {
+        memcpy(&data, crc_msg, sizeof(data));
+        crc64 = _mm_crc32_u64(crc64, data);
+        crc_msg += 8;
+        len -= 8;
+    }
+    crc = (UINT32)crc64;
+#endif
+    while (len-- > 0)
+        crc = _mm_crc32_u8(crc, *crc_msg++);
+    return crc;
+}
+
+// Returns nonzero if the CPU supports SSE4.2
+static int Crc32cHwSupported(void)
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+    return (ecx & bit_SSE4_2) != 0;
+#endif
+}
+#elif defined(CRC32C_ARM)
+// Calculates a CRC-32C using the ARMv8 CRC32 instructions
+static UINT32 Crc32cCalcHw(const unsigned char* crc_msg, int len, UINT32 crc)
+{
+    uint64_t data;
+
+    while (len >= 8)
+    {
+        memcpy(&data, crc_msg, sizeof(data));
+        crc = __crc32cd(crc, data);
+        crc_msg += 8;
+        len -= 8;
+    }
+    while (len-- > 0)
+        crc = __crc32cb(crc, *crc_msg++);
+    return crc;
+}
+
+// Returns nonzero if the CPU supports the CRC32 instructions
+static int Crc32cHwSupported(void)
+{
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return 1;
+#endif
+}
+#endif
+
+// Calculates a CRC-32C (Castagnoli) 
+// @param[in] crc_msg - pointer to data buffer.
+// @param[in] len - number of bytes in buffer.
+// @param[in] crc - crc seed value (normally set to 0), but can to calculate the  
+//          CRC a few bytes at a time by passing in the intermediary value. 
+// @return The calculated CRC. 
+UINT32 Crc32cCalcBlock(const unsigned char* crc_msg, int len, UINT32 crc)
+{
+    // Use the fastest kernel selected by Crc32cInit()
+    return ~crc32cKernel(crc_msg, len, ~crc);
+}
+
+// Initialize the CRC-32C module. Builds the table and selects the fastest
+// kernel supported by the CPU. Results are identical for every kernel.
+void Crc32cInit(void)
+{
+    int n, i;
+    UINT32 crc;
+
+    for (i = 0; i < 256; i++)
+    {
+        crc = (UINT32)i;
+        for (n = 0; n < 8; n++)
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        crc32c_table[i] = crc;
+    }
+
+    crc32cKernel = Crc32cCalcTable;
+#if defined(CRC32C_X86) || defined(CRC32C_ARM)
+    if (Crc32cHwSupported())
+        crc32cKernel = Crc32cCalcHw;
+#endif
+}
+
+#endif // USE_SSP_CRC32C
@@ -1,13 +1,21 @@
 #ifndef _CRC_H
 #define _CRC_H
 
+#include "ssp_types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+void Crc16Init(void);
+
 unsigned short Crc16CalcBlock(unsigned char* crc_msg, int len,
     unsigned short crc);
 
+void Crc32cInit(void);
+
+UINT32 Crc32cCalcBlock(const unsigned char* crc_msg, int len, UINT32 crc);
+
 #ifdef __cplusplus 
 }
 #endif
@@ -26,6 +26,14 @@ BOOL SSPHAL_IsRecvQueueEmpty(SspPortId portId);
 void SSPHAL_PowerSave(BOOL enable);
 BOOL SSPHAL_IsPowerSave(void);
 
+// Optional CRC offload to a CRC peripheral or DMA engine. Return FALSE from
+// SSPHAL_CrcOffloadSupported() to compute the CRC in software. Otherwise, 
+// SSPHAL_CrcCompute() continues the CRC of the preceding bytes (or the seed)
+// and must return the same value as Crc16CalcBlock() or Crc32cCalcBlock().
+BOOL SSPHAL_CrcOffloadSupported(SspPortId portId, SspFrameCheck frameCheck);
+UINT32 SSPHAL_CrcCompute(SspPortId portId, SspFrameCheck frameCheck, 
+    const UINT8* data, UINT16 dataSize, UINT32 crc);
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,18 +22,68 @@
 #define SSP_STRINGIZE2(x) #x
 #include SSP_STRINGIZE(SSP_CONFIG)
 #else
-// How long to wait for remote CPU to provide and ACK or NAK
+// How long to wait for remote CPU to provide and ACK or NAK before the first
+// round trip time is measured
 #define SSP_ACK_TIMEOUT     200    // in mS
 
+// Limits of the adaptive ACK timeout computed from measured round trip times
+#define SSP_ACK_TIMEOUT_MIN 20     // in mS
+#define SSP_ACK_TIMEOUT_MAX 2000   // in mS
+
+// How long to hold ACKs for received messages so multiple messages are 
+// acknowledged with one SACK packet. Must be less than SSP_ACK_TIMEOUT.
+#define SSP_ACK_DELAY       0      // in mS
+
 // How many times to retry a failed message
 #define SSP_MAX_RETRIES     4
 
 // How long to wait for a incoming character polling com port
 #define SSP_RECV_TIMEOUT    10  // in mS
 
+// Maximum number of packets received per port each SSP_Process() call. 
+// 0 receives all available packets.
+#define SSP_RECV_PACKET_BUDGET  1
+
+// Maximum time spent receiving per port each SSP_Process() call. 0 is no limit.
+#define SSP_RECV_TIME_BUDGET    0   // in mS
+
 // Maximum number of outgoing messages per port that can be queued
 #define SSP_MAX_MESSAGES    5
 
+// Number of SSP_MAX_MESSAGES queue blocks sized for message bodies up to 16, 64 
+// and 128 bytes. The remaining blocks (at least one) are maximum body size. 
+// Smaller blocks allow a larger SSP_MAX_MESSAGES within the same RAM. Messages 
+// use the next larger block size when a size is exhausted.
+#define SSP_DATA_BLOCKS_16  0
+#define SSP_DATA_BLOCKS_64  0
+#define SSP_DATA_BLOCKS_128 0
+
+// Maximum number of unacknowledged outgoing messages in flight per port 
+// (1 to SSP_MAX_MESSAGES, at most 64). Change at runtime using SSP_SetSendWindow().
+#define SSP_SEND_WINDOW     1
+
+// Define to send 16-bit transaction IDs within data messages. Uses 1 byte of
+// each message body. The remote CPU must support extended transaction IDs.
+//#define USE_SSP_EXT_SEQ
+
+// Define to send data larger than one packet as multiple fragments, up to 255 
+// fragments per message. A fragmented message uses one queue entry.
+//#define USE_SSP_FRAGMENTATION
+
+// Maximum size of a fragmented message. Each socket has a reassembly buffer
+// of this size.
+#define SSP_MAX_MESSAGE_SIZE 1024
+
+// Maximum number of fragmented messages queued at once on all ports. Each 
+// queued fragmented message uses a SSP_MAX_MESSAGE_SIZE send buffer.
+#define SSP_FRAG_MESSAGES   1
+
+// Number of receive buffers. Listener callbacks may retain up to 
+// SSP_RECV_BUFFERS - 1 received packets using SSP_RetainRecv(). Messages 
+// received ahead of a missing message are also held in these buffers, so 
+// use at least the remote CPU send window + 1.
+#define SSP_RECV_BUFFERS    (SSP_SEND_WINDOW + 1)
+
 // Maximum packet size including header, body and CRC (max value 256)
 #define SSP_MAX_PACKET_SIZE 64
 
@@ -43,10 +93,29 @@
 // Define uses fixed block allocator. Undefine uses malloc/free. 
 #define USE_FB_ALLOCATOR
 
+// Define to cache up to SSP_ALLOC_MAGAZINE_SIZE free blocks per thread for each
+// fixed block allocator, so most allocations avoid the shared free-list. Each
+// allocator pool grows by SSP_ALLOC_MAGAZINE_SIZE blocks for each of up to 
+// SSP_ALLOC_MAGAZINE_THREADS threads. Threads call ALLOC_ThreadFlush() before 
+// exiting. Requires thread-local storage and 8-byte compare-and-swap.
+//#define USE_SSP_ALLOC_MAGAZINE
+#define SSP_ALLOC_MAGAZINE_SIZE     4
+#define SSP_ALLOC_MAGAZINE_THREADS  4
+
+// Define to compute CRCs using slicing-by-8 tables (3.5K bytes of RAM) and a 
+// carry-less multiply kernel if the CPU supports it. Undefine uses one table.
+#define USE_SSP_CRC_SLICING
+
+// Define to support a CRC-32C frame check selectable per port using 
+// SSP_SetFrameCheck(). The 4-byte footer reduces the maximum body size by 2 
+// bytes. The remote CPU must also define USE_SSP_CRC32C.
+//#define USE_SSP_CRC32C
+
 // Arduino build options
 #ifdef ARDUINO
 #define SSP_OSAL        SSP_OSAL_NO_OS
 #define SSP_HAL         SSP_HAL_ARDUINO
+#undef USE_SSP_CRC_SLICING
 #endif
 
 // Windows build options
@@ -62,6 +131,7 @@
 #ifdef BARE_METAL
 #define SSP_OSAL        SSP_OSAL_NO_OS
 #define SSP_HAL         SSP_HAL_MEM_BUF
+#undef USE_SSP_CRC_SLICING
 #endif
 
 // GCC build options